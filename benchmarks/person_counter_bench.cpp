@@ -0,0 +1,222 @@
+/*
+ * This file is part of [Head Count Web Application].
+ *
+ * Copyright (C) 2025 TakumiVision co., ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// ホットパス各段のマイクロベンチマーク（Google Benchmark）
+// ビルド方法は benchmarks/README.md を参照
+
+#include <benchmark/benchmark.h>
+
+#include <fstream>
+#include <random>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+#include <opencv2/dnn.hpp>
+
+#include "../src/person_counter.h"
+
+namespace {
+
+// 疑似カメラフレームを生成する（実フレームの代わり。ノイズ画像はJPEGの
+// 最悪ケースに近く、デコード・前処理の比較には十分）
+cv::Mat makeFrame(int width, int height)
+{
+    cv::Mat frame(height, width, CV_8UC3);
+    cv::randu(frame, cv::Scalar(0, 0, 0), cv::Scalar(255, 255, 255));
+    return frame;
+}
+
+std::vector<unsigned char> encodeJpeg(const cv::Mat &frame)
+{
+    std::vector<unsigned char> jpeg;
+    cv::imencode(".jpg", frame, jpeg, {cv::IMWRITE_JPEG_QUALITY, 90});
+    return jpeg;
+}
+
+} // namespace
+
+// レターボックス前処理（formatToSquare相当：リサイズ＋キャンバスコピー）
+static void BM_Letterbox(benchmark::State &state)
+{
+    int width = (int)state.range(0);
+    int height = (int)state.range(1);
+    cv::Mat frame = makeFrame(width, height);
+    cv::Mat canvas = cv::Mat::zeros(640, 640, CV_8UC3);
+
+    float scale = std::min(640.0f / width, 640.0f / height);
+    int resized_w = width * scale;
+    int resized_h = height * scale;
+    int pad_x = (640 - resized_w) / 2;
+    int pad_y = (640 - resized_h) / 2;
+
+    for (auto _ : state) {
+        cv::Mat target = canvas(cv::Rect(pad_x, pad_y, resized_w, resized_h));
+        cv::resize(frame, target, cv::Size(resized_w, resized_h));
+        benchmark::DoNotOptimize(canvas.data);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * frame.total() * 3);
+}
+BENCHMARK(BM_Letterbox)->Args({1920, 1080})->Args({3840, 2160});
+
+// blobFromImage（NCHW化・正規化）
+static void BM_BlobFromImage(benchmark::State &state)
+{
+    cv::Mat canvas = makeFrame(640, 640);
+    cv::Mat blob;
+    for (auto _ : state) {
+        cv::dnn::blobFromImage(canvas, blob, 1.0 / 255.0, cv::Size(640, 640),
+                               cv::Scalar(), true, false);
+        benchmark::DoNotOptimize(blob.data);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BlobFromImage);
+
+// 8400行の単一クラスデコードループ（閾値スキャン）
+static void BM_DecodeLoopSingleClass(benchmark::State &state)
+{
+    const int anchors = 8400;
+    cv::Mat output(5, anchors, CV_32F);
+    cv::randu(output, 0.0f, 1.0f);
+    const float *scores = output.ptr<float>(4);
+    std::vector<int> candidates;
+    candidates.reserve(anchors);
+
+    for (auto _ : state) {
+        candidates.clear();
+        for (int i = 0; i < anchors; ++i) {
+            if (scores[i] > 0.9f) {
+                candidates.push_back(i);
+            }
+        }
+        benchmark::DoNotOptimize(candidates.data());
+    }
+    state.SetItemsProcessed(state.iterations() * anchors);
+}
+BENCHMARK(BM_DecodeLoopSingleClass);
+
+// 旧実装相当：行ごとのcv::minMaxLoc（比較用）
+static void BM_DecodeLoopMinMaxLoc(benchmark::State &state)
+{
+    const int anchors = 8400;
+    cv::Mat output(anchors, 5, CV_32F);
+    cv::randu(output, 0.0f, 1.0f);
+
+    for (auto _ : state) {
+        float *data = (float *)output.data;
+        int hits = 0;
+        for (int i = 0; i < anchors; ++i) {
+            cv::Mat scores(1, 1, CV_32FC1, data + 4);
+            double maxScore;
+            cv::minMaxLoc(scores, 0, &maxScore, 0, 0);
+            if (maxScore > 0.9) {
+                ++hits;
+            }
+            data += 5;
+        }
+        benchmark::DoNotOptimize(hits);
+    }
+    state.SetItemsProcessed(state.iterations() * anchors);
+}
+BENCHMARK(BM_DecodeLoopMinMaxLoc);
+
+// cv::dnn::NMSBoxes（候補数パラメータ付き）
+static void BM_NMSBoxes(benchmark::State &state)
+{
+    int candidates = (int)state.range(0);
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> pos(0, 600);
+    std::uniform_real_distribution<float> conf(0.2f, 1.0f);
+
+    std::vector<cv::Rect> boxes;
+    std::vector<float> confidences;
+    for (int i = 0; i < candidates; ++i) {
+        boxes.emplace_back(pos(gen), pos(gen), 40, 40);
+        confidences.push_back(conf(gen));
+    }
+
+    std::vector<int> result;
+    for (auto _ : state) {
+        result.clear();
+        cv::dnn::NMSBoxes(boxes, confidences, 0.2f, 0.5f, result);
+        benchmark::DoNotOptimize(result.data());
+    }
+    state.SetItemsProcessed(state.iterations() * candidates);
+}
+BENCHMARK(BM_NMSBoxes)->Arg(100)->Arg(500)->Arg(1000);
+
+// JPEGデコード（1080p / 4K）
+static void BM_JpegDecode(benchmark::State &state)
+{
+    int width = (int)state.range(0);
+    int height = (int)state.range(1);
+    std::vector<unsigned char> jpeg = encodeJpeg(makeFrame(width, height));
+
+    for (auto _ : state) {
+        cv::Mat img = cv::imdecode(jpeg, cv::IMREAD_COLOR);
+        benchmark::DoNotOptimize(img.data);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * jpeg.size());
+}
+BENCHMARK(BM_JpegDecode)->Args({1920, 1080})->Args({3840, 2160});
+
+// エンドツーエンド：PersonCounter::detectHeads
+// モデルファイルが存在する場合のみ登録される（カレントディレクトリを
+// リポジトリルートにして実行すること）
+static void BM_DetectHeadsEndToEnd(benchmark::State &state)
+{
+    static PersonCounter counter;
+
+    int width = (int)state.range(0);
+    int height = (int)state.range(1);
+    std::vector<unsigned char> jpeg = encodeJpeg(makeFrame(width, height));
+
+    std::vector<OBJPos> vertices;
+    vertices.emplace_back(0, 0);
+    vertices.emplace_back(width, 0);
+    vertices.emplace_back(width, height);
+    vertices.emplace_back(0, height);
+    Thresholds thresholds(0.2f, 0.2f, 0.2f);
+
+    for (auto _ : state) {
+        std::vector<Rect> heads = counter.detectHeads(jpeg, vertices, thresholds);
+        benchmark::DoNotOptimize(heads.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * jpeg.size());
+}
+
+int main(int argc, char **argv)
+{
+    std::ifstream model("./model/yolov8x_head.onnx");
+    if (model.good()) {
+        benchmark::RegisterBenchmark("BM_DetectHeadsEndToEnd",
+                                     BM_DetectHeadsEndToEnd)
+            ->Args({1920, 1080})
+            ->Args({3840, 2160})
+            ->Unit(benchmark::kMillisecond);
+    }
+
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,508 @@
+/*
+ * This file is part of [Head Count Web Application].
+ *
+ * Copyright (C) 2025 TakumiVision co., ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "backend.h"
+
+#include <fstream>
+
+#include <opencv2/dnn.hpp>
+#include <spdlog/spdlog.h>
+
+// ---------------------------------------------------------------------------
+// OpenCV DNN backend (always available)
+// ---------------------------------------------------------------------------
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Memory-map the ONNX file and parse it from the mapping, so the model bytes
+// are paged in on demand instead of being copied through a heap buffer. Falls
+// back to the path-based loader on any error.
+static cv::dnn::Net readNetMapped(const std::string &modelPath)
+{
+    int fd = open(modelPath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return cv::dnn::readNetFromONNX(modelPath);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return cv::dnn::readNetFromONNX(modelPath);
+    }
+    void *mapped = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        return cv::dnn::readNetFromONNX(modelPath);
+    }
+    cv::dnn::Net net =
+        cv::dnn::readNetFromONNX((const char *)mapped, (size_t)st.st_size);
+    munmap(mapped, (size_t)st.st_size);
+    return net;
+}
+#else
+static cv::dnn::Net readNetMapped(const std::string &modelPath)
+{
+    return cv::dnn::readNetFromONNX(modelPath);
+}
+#endif
+
+class OpenCVBackend : public IBackend
+{
+  public:
+    OpenCVBackend(const std::string &modelPath, bool useCuda,
+                  InferencePrecision precision, int deviceId)
+    {
+        // cv::dnn binds its CUDA state to the device that is current when
+        // the net is first initialized, so select it before anything else.
+        // Non-default devices are re-selected per forward in case the
+        // calling thread ran on another device in between.
+        if (useCuda && deviceId > 0) {
+            try {
+                cv::cuda::setDevice(deviceId);
+                cudaDevice = deviceId;
+                spdlog::info("Using CUDA device {}", deviceId);
+            }
+            catch (const cv::Exception &e) {
+                spdlog::warn("CUDA device {} unavailable ({}); using device 0",
+                             deviceId, e.what());
+            }
+        }
+        net = readNetMapped(modelPath);
+        if (precision == InferencePrecision::INT8) {
+            spdlog::warn(
+                "INT8 is only supported on the TensorRT backend; running FP32");
+            precision = InferencePrecision::FP32;
+        }
+        if (useCuda) {
+            if (precision == InferencePrecision::FP16) {
+                spdlog::info("Running on CUDA (FP16)");
+                net.setPreferableBackend(cv::dnn::DNN_BACKEND_CUDA);
+                net.setPreferableTarget(cv::dnn::DNN_TARGET_CUDA_FP16);
+            }
+            else {
+                spdlog::info("Running on CUDA");
+                net.setPreferableBackend(cv::dnn::DNN_BACKEND_CUDA);
+                net.setPreferableTarget(cv::dnn::DNN_TARGET_CUDA);
+            }
+        }
+        else {
+            if (precision == InferencePrecision::FP16) {
+                spdlog::warn("FP16 requested without CUDA; running FP32 on CPU");
+            }
+            spdlog::info("Running on CPU");
+            net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+            net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+        }
+    }
+
+    std::vector<cv::Mat> forward(const cv::Mat &blob) override
+    {
+        if (cudaDevice > 0) {
+            cv::cuda::setDevice(cudaDevice);
+        }
+        net.setInput(blob);
+        std::vector<cv::Mat> outputs;
+        net.forward(outputs, net.getUnconnectedOutLayersNames());
+        return outputs;
+    }
+
+  private:
+    cv::dnn::Net net;
+    int cudaDevice = -1; // >0: re-select this CUDA device before forwards
+};
+
+// ---------------------------------------------------------------------------
+// ONNX Runtime backend
+// ---------------------------------------------------------------------------
+
+#ifdef WITH_ONNXRUNTIME
+#include <onnxruntime_cxx_api.h>
+
+class OrtBackend : public IBackend
+{
+  public:
+    OrtBackend(const std::string &modelPath, bool useCuda, int deviceId)
+        : env(ORT_LOGGING_LEVEL_WARNING, "person_counter")
+    {
+        Ort::SessionOptions options;
+        options.SetGraphOptimizationLevel(
+            GraphOptimizationLevel::ORT_ENABLE_ALL);
+        if (useCuda) {
+            OrtCUDAProviderOptions cudaOptions{};
+            cudaOptions.device_id = deviceId;
+            options.AppendExecutionProvider_CUDA(cudaOptions);
+            spdlog::info(
+                "ONNX Runtime backend with CUDA execution provider (device {})",
+                deviceId);
+        }
+        else {
+            spdlog::info("ONNX Runtime backend on CPU");
+        }
+        session = std::make_unique<Ort::Session>(env, modelPath.c_str(), options);
+
+        Ort::AllocatorWithDefaultOptions allocator;
+        inputName = session->GetInputNameAllocated(0, allocator).get();
+        size_t numOutputs = session->GetOutputCount();
+        for (size_t i = 0; i < numOutputs; ++i) {
+            outputNames.push_back(
+                session->GetOutputNameAllocated(i, allocator).get());
+        }
+    }
+
+    std::vector<cv::Mat> forward(const cv::Mat &blob) override
+    {
+        std::vector<int64_t> shape(blob.dims);
+        size_t elements = 1;
+        for (int d = 0; d < blob.dims; ++d) {
+            shape[d] = blob.size[d];
+            elements *= (size_t)blob.size[d];
+        }
+
+        Ort::MemoryInfo memInfo =
+            Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+        Ort::Value input = Ort::Value::CreateTensor<float>(
+            memInfo, (float *)blob.data, elements, shape.data(), shape.size());
+
+        std::vector<const char *> outNames;
+        for (auto &&name : outputNames) {
+            outNames.push_back(name.c_str());
+        }
+        const char *inName = inputName.c_str();
+        auto ortOutputs =
+            session->Run(Ort::RunOptions{nullptr}, &inName, &input, 1,
+                         outNames.data(), outNames.size());
+
+        // Copy each output tensor into a Mat in cv::dnn's layout
+        std::vector<cv::Mat> outputs;
+        for (auto &&value : ortOutputs) {
+            auto info = value.GetTensorTypeAndShapeInfo();
+            std::vector<int64_t> outShape = info.GetShape();
+            std::vector<int> dims(outShape.begin(), outShape.end());
+            cv::Mat out((int)dims.size(), dims.data(), CV_32F);
+            std::memcpy(out.data, value.GetTensorData<float>(),
+                        out.total() * sizeof(float));
+            outputs.push_back(out);
+        }
+        return outputs;
+    }
+
+  private:
+    Ort::Env env;
+    std::unique_ptr<Ort::Session> session;
+    std::string inputName;
+    std::vector<std::string> outputNames;
+};
+#endif // WITH_ONNXRUNTIME
+
+// ---------------------------------------------------------------------------
+// TensorRT backend with on-disk engine cache
+// ---------------------------------------------------------------------------
+
+#ifdef WITH_TENSORRT
+#include <NvInfer.h>
+#include <NvOnnxParser.h>
+#include <cuda_runtime_api.h>
+
+class TrtLogger : public nvinfer1::ILogger
+{
+    void log(Severity severity, const char *msg) noexcept override
+    {
+        if (severity <= Severity::kWARNING) {
+            spdlog::warn("TensorRT: {}", msg);
+        }
+    }
+};
+
+// INT8 entropy calibrator: feeds preprocessed calibration images through the
+// builder and caches the resulting table next to the model so calibration
+// runs once per deployment.
+class Int8Calibrator : public nvinfer1::IInt8EntropyCalibrator2
+{
+  public:
+    Int8Calibrator(const std::string &calibrationDir,
+                   const std::string &cachePath, const nvinfer1::Dims &inputDims)
+        : cachePath(cachePath), inputDims(inputDims)
+    {
+        cv::glob(calibrationDir + "/*.jpg", imagePaths, false);
+        batchBytes = 1;
+        for (int d = 1; d < inputDims.nbDims; ++d) {
+            batchBytes *= (size_t)inputDims.d[d];
+        }
+        batchBytes *= sizeof(float);
+        cudaMalloc(&deviceInput, batchBytes);
+    }
+
+    ~Int8Calibrator() override
+    {
+        cudaFree(deviceInput);
+    }
+
+    int getBatchSize() const noexcept override
+    {
+        return 1;
+    }
+
+    bool getBatch(void *bindings[], const char *[], int) noexcept override
+    {
+        if (nextImage >= imagePaths.size()) {
+            return false;
+        }
+        cv::Mat img = cv::imread(imagePaths[nextImage++], cv::IMREAD_COLOR);
+        if (img.empty()) {
+            return getBatch(bindings, nullptr, 0);
+        }
+        cv::Size inputSize((int)inputDims.d[3], (int)inputDims.d[2]);
+        cv::Mat blob;
+        cv::dnn::blobFromImage(img, blob, 1.0 / 255.0, inputSize, cv::Scalar(),
+                               true, false);
+        cudaMemcpy(deviceInput, blob.data, batchBytes, cudaMemcpyHostToDevice);
+        bindings[0] = deviceInput;
+        return true;
+    }
+
+    const void *readCalibrationCache(size_t &length) noexcept override
+    {
+        cache.clear();
+        std::ifstream file(cachePath, std::ios::binary | std::ios::ate);
+        if (!file) {
+            length = 0;
+            return nullptr;
+        }
+        std::streamsize size = file.tellg();
+        file.seekg(0, std::ios::beg);
+        cache.resize(size);
+        file.read(cache.data(), size);
+        length = cache.size();
+        return cache.data();
+    }
+
+    void writeCalibrationCache(const void *data, size_t length) noexcept override
+    {
+        std::ofstream file(cachePath, std::ios::binary);
+        file.write((const char *)data, length);
+    }
+
+  private:
+    std::string cachePath;
+    nvinfer1::Dims inputDims;
+    std::vector<cv::String> imagePaths;
+    size_t nextImage = 0;
+    size_t batchBytes = 0;
+    void *deviceInput = nullptr;
+    std::vector<char> cache;
+};
+
+class TrtBackend : public IBackend
+{
+  public:
+    TrtBackend(const std::string &modelPath, InferencePrecision precision,
+               const std::string &calibrationDir, int deviceId)
+        : cudaDevice(deviceId)
+    {
+        cudaSetDevice(cudaDevice);
+        std::string enginePath = modelPath + ".engine";
+        std::vector<char> engineData = loadEngineCache(enginePath);
+        if (engineData.empty()) {
+            spdlog::info("Building TensorRT engine (one-time cost)...");
+            engineData =
+                buildEngine(modelPath, enginePath, precision, calibrationDir);
+        }
+
+        runtime.reset(nvinfer1::createInferRuntime(logger));
+        engine.reset(runtime->deserializeCudaEngine(engineData.data(),
+                                                    engineData.size()));
+        if (!engine) {
+            throw std::runtime_error("Failed to deserialize TensorRT engine");
+        }
+        context.reset(engine->createExecutionContext());
+    }
+
+    ~TrtBackend() override
+    {
+        for (auto &&buffer : deviceBuffers) {
+            cudaFree(buffer);
+        }
+    }
+
+    std::vector<cv::Mat> forward(const cv::Mat &blob) override
+    {
+        cudaSetDevice(cudaDevice);
+        nvinfer1::Dims inputDims;
+        inputDims.nbDims = blob.dims;
+        for (int d = 0; d < blob.dims; ++d) {
+            inputDims.d[d] = blob.size[d];
+        }
+        context->setBindingDimensions(0, inputDims);
+        ensureBuffers();
+
+        size_t inputBytes = blob.total() * sizeof(float);
+        cudaMemcpy(deviceBuffers[0], blob.data, inputBytes,
+                   cudaMemcpyHostToDevice);
+        context->executeV2(deviceBuffers.data());
+
+        std::vector<cv::Mat> outputs;
+        for (int b = 1; b < engine->getNbBindings(); ++b) {
+            nvinfer1::Dims dims = context->getBindingDimensions(b);
+            std::vector<int> matDims(dims.d, dims.d + dims.nbDims);
+            cv::Mat out((int)matDims.size(), matDims.data(), CV_32F);
+            cudaMemcpy(out.data, deviceBuffers[b], out.total() * sizeof(float),
+                       cudaMemcpyDeviceToHost);
+            outputs.push_back(out);
+        }
+        return outputs;
+    }
+
+  private:
+    static std::vector<char> loadEngineCache(const std::string &enginePath)
+    {
+        std::ifstream cache(enginePath, std::ios::binary | std::ios::ate);
+        if (!cache) {
+            return {};
+        }
+        std::streamsize size = cache.tellg();
+        cache.seekg(0, std::ios::beg);
+        std::vector<char> data(size);
+        cache.read(data.data(), size);
+        return data;
+    }
+
+    std::vector<char> buildEngine(const std::string &modelPath,
+                                  const std::string &enginePath,
+                                  InferencePrecision precision,
+                                  const std::string &calibrationDir)
+    {
+        std::unique_ptr<nvinfer1::IBuilder> builder(
+            nvinfer1::createInferBuilder(logger));
+        std::unique_ptr<nvinfer1::INetworkDefinition> network(
+            builder->createNetworkV2(
+                1U << (uint32_t)nvinfer1::NetworkDefinitionCreationFlag::
+                    kEXPLICIT_BATCH));
+        std::unique_ptr<nvonnxparser::IParser> parser(
+            nvonnxparser::createParser(*network, logger));
+        if (!parser->parseFromFile(
+                modelPath.c_str(),
+                (int)nvinfer1::ILogger::Severity::kWARNING)) {
+            throw std::runtime_error("Failed to parse ONNX model for TensorRT");
+        }
+
+        std::unique_ptr<nvinfer1::IBuilderConfig> config(
+            builder->createBuilderConfig());
+        config->setMemoryPoolLimit(nvinfer1::MemoryPoolType::kWORKSPACE,
+                                   1ULL << 30);
+
+        std::unique_ptr<Int8Calibrator> calibrator;
+        if (precision == InferencePrecision::FP16) {
+            config->setFlag(nvinfer1::BuilderFlag::kFP16);
+            spdlog::info("TensorRT engine will be built with FP16");
+        }
+        else if (precision == InferencePrecision::INT8) {
+            if (calibrationDir.empty()) {
+                throw std::runtime_error(
+                    "INT8 precision requires a calibration image directory");
+            }
+            config->setFlag(nvinfer1::BuilderFlag::kINT8);
+            calibrator = std::make_unique<Int8Calibrator>(
+                calibrationDir, modelPath + ".calib",
+                network->getInput(0)->getDimensions());
+            config->setInt8Calibrator(calibrator.get());
+            spdlog::info("TensorRT engine will be built with INT8");
+        }
+
+        std::unique_ptr<nvinfer1::IHostMemory> serialized(
+            builder->buildSerializedNetwork(*network, *config));
+        if (!serialized) {
+            throw std::runtime_error("Failed to build TensorRT engine");
+        }
+
+        std::ofstream cache(enginePath, std::ios::binary);
+        cache.write((const char *)serialized->data(), serialized->size());
+        spdlog::info("TensorRT engine cached to {}", enginePath);
+
+        return std::vector<char>((const char *)serialized->data(),
+                                 (const char *)serialized->data()
+                                     + serialized->size());
+    }
+
+    void ensureBuffers()
+    {
+        if (!deviceBuffers.empty()) {
+            return;
+        }
+        for (int b = 0; b < engine->getNbBindings(); ++b) {
+            nvinfer1::Dims dims = context->getBindingDimensions(b);
+            size_t elements = 1;
+            for (int d = 0; d < dims.nbDims; ++d) {
+                elements *= (size_t)dims.d[d];
+            }
+            void *buffer = nullptr;
+            cudaMalloc(&buffer, elements * sizeof(float));
+            deviceBuffers.push_back(buffer);
+        }
+    }
+
+    TrtLogger logger;
+    std::unique_ptr<nvinfer1::IRuntime> runtime;
+    std::unique_ptr<nvinfer1::ICudaEngine> engine;
+    std::unique_ptr<nvinfer1::IExecutionContext> context;
+    std::vector<void *> deviceBuffers;
+    int cudaDevice = 0; // CUDA device this engine is bound to
+};
+#endif // WITH_TENSORRT
+
+std::unique_ptr<IBackend> createBackend(InferenceBackend kind,
+                                        const std::string &modelPath,
+                                        bool useCuda,
+                                        InferencePrecision precision,
+                                        const std::string &calibrationDir,
+                                        int deviceId)
+{
+    switch (kind) {
+        case InferenceBackend::OnnxRuntime:
+#ifdef WITH_ONNXRUNTIME
+            if (precision != InferencePrecision::FP32) {
+                spdlog::warn(
+                    "Precision control is not wired for ONNX Runtime; running "
+                    "FP32");
+            }
+            return std::make_unique<OrtBackend>(modelPath, useCuda, deviceId);
+#else
+            spdlog::warn(
+                "ONNX Runtime backend requested but not built in; falling back "
+                "to OpenCV");
+            break;
+#endif
+        case InferenceBackend::TensorRT:
+#ifdef WITH_TENSORRT
+            return std::make_unique<TrtBackend>(modelPath, precision,
+                                                calibrationDir, deviceId);
+#else
+            spdlog::warn(
+                "TensorRT backend requested but not built in; falling back to "
+                "OpenCV");
+            break;
+#endif
+        case InferenceBackend::OpenCV:
+            break;
+    }
+    return std::make_unique<OpenCVBackend>(modelPath, useCuda, precision,
+                                           deviceId);
+}
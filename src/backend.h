@@ -0,0 +1,66 @@
+/*
+ * This file is part of [Head Count Web Application].
+ *
+ * Copyright (C) 2025 TakumiVision co., ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BACKEND_H__
+#define __BACKEND_H__
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+// Execution backend selection for Inference. OnnxRuntime and TensorRT are
+// only available when the module is built with -DWITH_ONNXRUNTIME /
+// -DWITH_TENSORRT; requesting an unavailable backend falls back to OpenCV
+// with a warning.
+enum class InferenceBackend {
+    OpenCV,      // cv::dnn (CUDA or CPU target)
+    OnnxRuntime, // ONNX Runtime with CUDA execution provider
+    TensorRT     // TensorRT with on-disk engine cache
+};
+
+// Numeric precision for inference. FP16 maps to DNN_TARGET_CUDA_FP16 on the
+// OpenCV path and the FP16 builder flag on TensorRT. INT8 is TensorRT-only
+// and needs a calibration image directory; the calibration table is cached
+// next to the model (<modelPath>.calib).
+enum class InferencePrecision {
+    FP32,
+    FP16,
+    INT8
+};
+
+// Minimal execution interface behind Inference: take a preprocessed NCHW
+// float blob, return the raw output tensors in the layout cv::dnn produces
+// so the decode path stays backend-agnostic.
+class IBackend
+{
+  public:
+    virtual ~IBackend() = default;
+    virtual std::vector<cv::Mat> forward(const cv::Mat &blob) = 0;
+};
+
+// Create a backend for the given model. For TensorRT the serialized engine
+// is cached next to the model (<modelPath>.engine) so the build cost is paid
+// once at deploy time. deviceId selects the CUDA device the backend binds
+// to (ignored on CPU); device 0 is the implicit default.
+std::unique_ptr<IBackend> createBackend(
+    InferenceBackend kind, const std::string &modelPath, bool useCuda,
+    InferencePrecision precision = InferencePrecision::FP32,
+    const std::string &calibrationDir = "", int deviceId = 0);
+#endif
@@ -0,0 +1,124 @@
+/*
+ * This file is part of [Head Count Web Application].
+ *
+ * Copyright (C) 2025 TakumiVision co., ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "batch_scheduler.h"
+
+#include <spdlog/spdlog.h>
+
+BatchScheduler::BatchScheduler(std::shared_ptr<Inference> inference,
+                               int maxBatchSize, std::chrono::microseconds window)
+    : inf(std::move(inference)), maxBatchSize(maxBatchSize), window(window)
+{
+    if (this->maxBatchSize < 1) {
+        this->maxBatchSize = 1;
+    }
+    scheduler = std::thread(&BatchScheduler::schedulerLoop, this);
+}
+
+BatchScheduler::~BatchScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    jobArrived.notify_all();
+    if (scheduler.joinable()) {
+        scheduler.join();
+    }
+}
+
+std::future<std::vector<Detection>> BatchScheduler::submit(
+    const cv::Mat &image, float confidenceThreshold, float scoreThreshold,
+    float nmsThreshold, int maxDetections)
+{
+    PendingJob job;
+    job.image = image;
+    job.confidenceThreshold = confidenceThreshold;
+    job.scoreThreshold = scoreThreshold;
+    job.nmsThreshold = nmsThreshold;
+    job.maxDetections = maxDetections;
+    std::future<std::vector<Detection>> future = job.promise.get_future();
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        pending.push_back(std::move(job));
+    }
+    jobArrived.notify_one();
+    return future;
+}
+
+void BatchScheduler::schedulerLoop()
+{
+    while (true) {
+        std::vector<PendingJob> batch;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            // 最初のジョブが到着するまで待機
+            jobArrived.wait(lock, [&] { return stopping || !pending.empty(); });
+            if (stopping && pending.empty()) {
+                return;
+            }
+
+            // 収集ウィンドウの間、追加ジョブを待ってバッチを成長させる
+            auto deadline = std::chrono::steady_clock::now() + window;
+            while ((int)pending.size() < maxBatchSize && !stopping) {
+                if (jobArrived.wait_until(lock, deadline) ==
+                    std::cv_status::timeout) {
+                    break;
+                }
+            }
+
+            int take = std::min((int)pending.size(), maxBatchSize);
+            for (int i = 0; i < take; ++i) {
+                batch.push_back(std::move(pending.front()));
+                pending.pop_front();
+            }
+        }
+
+        std::vector<cv::Mat> images;
+        images.reserve(batch.size());
+        for (auto &&job : batch) {
+            images.push_back(job.image);
+        }
+
+        spdlog::trace("BatchScheduler: running batch of {}", images.size());
+
+        // 閾値はスケジューラスレッドだけが適用する（先頭要求の値を
+        // バッチ全体で共有する）
+        inf->setThresholds(batch[0].confidenceThreshold,
+                           batch[0].scoreThreshold, batch[0].nmsThreshold,
+                           batch[0].maxDetections);
+
+        // バッチ実行の例外はスケジューラスレッドを落とさず、バッチ内の
+        // 全futureへ伝播させる（呼び出し元のget()で再送出される）
+        try {
+            std::vector<std::vector<Detection>> results =
+                inf->runInferenceBatch(images);
+            for (size_t i = 0; i < batch.size(); ++i) {
+                batch[i].promise.set_value(std::move(results[i]));
+            }
+        }
+        catch (...) {
+            spdlog::error("BatchScheduler: batch of {} failed",
+                          images.size());
+            for (auto &&job : batch) {
+                job.promise.set_exception(std::current_exception());
+            }
+        }
+    }
+}
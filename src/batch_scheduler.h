@@ -0,0 +1,78 @@
+/*
+ * This file is part of [Head Count Web Application].
+ *
+ * Copyright (C) 2025 TakumiVision co., ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BATCH_SCHEDULER_H__
+#define __BATCH_SCHEDULER_H__
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "inference.h"
+
+// 動的マイクロバッチスケジューラ
+// 収集ウィンドウ内（既定5ms）に到着した推論要求をまとめ、1回のバッチ
+// フォワードとして実行し、結果をfuture経由で各呼び出し元へ返す。
+// 閾値はsubmit()で要求と一緒に渡し、スケジューラスレッドだけが
+// Inferenceへ適用する（呼び出し元から直接設定すると実行中のバッチと
+// 競合する）。同一バッチ内の要求は先頭要求の閾値を共有する点に注意。
+class BatchScheduler
+{
+  public:
+    explicit BatchScheduler(
+        std::shared_ptr<Inference> inference, int maxBatchSize = 8,
+        std::chrono::microseconds window = std::chrono::milliseconds(5));
+    ~BatchScheduler();
+
+    // 画像1枚の推論をスケジュールし、結果のfutureを返す
+    // 画像はバッチ実行まで参照されるため、futureの完了まで有効であること。
+    // バッチ実行が失敗した場合、futureのget()は例外を再送出する
+    std::future<std::vector<Detection>> submit(const cv::Mat &image,
+                                               float confidenceThreshold = 0.25f,
+                                               float scoreThreshold = 0.45f,
+                                               float nmsThreshold = 0.50f,
+                                               int maxDetections = 300);
+
+  private:
+    void schedulerLoop();
+
+    struct PendingJob
+    {
+        cv::Mat image;
+        float confidenceThreshold;
+        float scoreThreshold;
+        float nmsThreshold;
+        int maxDetections;
+        std::promise<std::vector<Detection>> promise;
+    };
+
+    std::shared_ptr<Inference> inf;   // バッチ実行に使うInference
+    int maxBatchSize;                 // 1バッチの最大枚数
+    std::chrono::microseconds window; // 収集ウィンドウ
+    std::deque<PendingJob> pending;   // 未実行ジョブ
+    std::mutex mtx;
+    std::condition_variable jobArrived;
+    std::thread scheduler;
+    bool stopping = false;
+};
+#endif
@@ -0,0 +1,163 @@
+/*
+ * This file is part of [Head Count Web Application].
+ *
+ * Copyright (C) 2025 TakumiVision co., ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "camera_ingest.h"
+
+#include <chrono>
+
+#include <spdlog/spdlog.h>
+
+#include "batch_scheduler.h"
+
+CameraIngest::CameraIngest(int batchSize)
+{
+    // バッチモード：1つのInferenceを全カメラで共有し、推論は
+    // マイクロバッチとしてまとめて実行する（デコードはカメラごとに並列）
+    if (batchSize > 0) {
+        sharedInference = PersonCounter::createDefaultInference();
+        scheduler = std::make_shared<BatchScheduler>(sharedInference, batchSize);
+    }
+}
+
+CameraIngest::~CameraIngest()
+{
+    stop();
+}
+
+void CameraIngest::setCallback(ResultCallback cb)
+{
+    callback = std::move(cb);
+}
+
+void CameraIngest::addCamera(const CameraConfig &config)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    if (cameras.count(config.cameraId)) {
+        spdlog::warn("Camera {} is already registered.", config.cameraId);
+        return;
+    }
+    CameraWorker worker;
+    worker.stopFlag = std::make_shared<std::atomic<bool>>(false);
+    worker.thread =
+        std::thread(&CameraIngest::cameraLoop, this, config, worker.stopFlag);
+    cameras[config.cameraId] = std::move(worker);
+}
+
+void CameraIngest::removeCamera(int cameraId)
+{
+    CameraWorker worker;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = cameras.find(cameraId);
+        if (it == cameras.end()) {
+            return;
+        }
+        worker = std::move(it->second);
+        cameras.erase(it);
+    }
+    worker.stopFlag->store(true);
+    if (worker.thread.joinable()) {
+        worker.thread.join();
+    }
+}
+
+void CameraIngest::stop()
+{
+    std::map<int, CameraWorker> toStop;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        toStop.swap(cameras);
+    }
+    // 先に全カメラへ停止を通知してから順番にjoinする
+    for (auto &&entry : toStop) {
+        entry.second.stopFlag->store(true);
+    }
+    for (auto &&entry : toStop) {
+        if (entry.second.thread.joinable()) {
+            entry.second.thread.join();
+        }
+    }
+}
+
+void CameraIngest::cameraLoop(CameraConfig config,
+                              std::shared_ptr<std::atomic<bool>> stopFlag)
+{
+    // カメラ専用のPersonCounterを生成（ログ初期化は行わない）
+    // バッチモードでは共有Inferenceを使い、推論をスケジューラへ委譲する
+    PersonCounter counter(sharedInference
+                              ? sharedInference
+                              : PersonCounter::createDefaultInference());
+    if (scheduler) {
+        counter.setBatchScheduler(scheduler);
+    }
+
+    double minIntervalSec = config.sampleFps > 0 ? 1.0 / config.sampleFps : 0.0;
+
+    while (!stopFlag->load()) {
+        // FFmpegバックエンドでハードウェアデコードを要求する
+        // （NVDEC/VAAPIが無い環境ではソフトウェアデコードへフォールバック）
+        std::vector<int> params = {cv::CAP_PROP_HW_ACCELERATION,
+                                   cv::VIDEO_ACCELERATION_ANY};
+        cv::VideoCapture cap(config.url, cv::CAP_FFMPEG, params);
+        if (!cap.isOpened()) {
+            spdlog::warn("Camera {}: failed to open {}; retrying",
+                         config.cameraId, config.url);
+            // 再接続まで待機（停止要求には即応答する）
+            for (int i = 0; i < 30 && !stopFlag->load(); ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+            continue;
+        }
+        spdlog::info("Camera {}: connected to {}", config.cameraId, config.url);
+
+        cv::Mat frame;
+        auto lastSample = std::chrono::steady_clock::time_point();
+        while (!stopFlag->load()) {
+            // grab()は全フレームで呼び、ストリームの滞留と遅延蓄積を防ぐ。
+            // デコード（retrieve）はサンプリング対象のフレームのみ行う
+            if (!cap.grab()) {
+                spdlog::warn("Camera {}: stream ended; reconnecting",
+                             config.cameraId);
+                break;
+            }
+            auto now = std::chrono::steady_clock::now();
+            if (minIntervalSec > 0
+                && std::chrono::duration<double>(now - lastSample).count()
+                       < minIntervalSec) {
+                continue;
+            }
+            lastSample = now;
+
+            if (!cap.retrieve(frame) || frame.empty()) {
+                continue;
+            }
+
+            std::vector<Rect> heads = counter.detectHeads(
+                frame, config.vertices, config.thresholds, config.cameraId);
+
+            if (callback) {
+                double ts = std::chrono::duration<double>(
+                                std::chrono::system_clock::now()
+                                    .time_since_epoch())
+                                .count();
+                callback(config.cameraId, ts, heads);
+            }
+        }
+    }
+}
@@ -0,0 +1,91 @@
+/*
+ * This file is part of [Head Count Web Application].
+ *
+ * Copyright (C) 2025 TakumiVision co., ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __CAMERA_INGEST_H__
+#define __CAMERA_INGEST_H__
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "person_counter.h"
+
+// カメラ1台分の取り込み設定
+struct CameraConfig
+{
+    int cameraId = 0;       // カメラ識別子（静止シーンゲートのキーにもなる）
+    std::string url;        // RTSPのURL
+    double sampleFps = 5.0; // 推論に回すフレームレート（0以下で全フレーム）
+    std::vector<OBJPos> vertices; // 検出対象領域の多角形頂点（空なら全画面）
+    Thresholds thresholds;        // 検出閾値
+};
+
+// RTSPカメラ取り込みサブシステム
+// カメラごとの専用スレッドがRTSPストリームをFFmpegバックエンドで
+// デコード（NVDEC/VAAPI等のハードウェアデコーダが使える環境では自動選択、
+// なければソフトウェアへフォールバック）し、デコード済みフレームを
+// JPEG再エンコードやHTTPを経由せずそのまま検出パイプラインへ渡す。
+// 結果は登録されたコールバックへ通知される。
+class CameraIngest
+{
+  public:
+    // (cameraId, UNIXタイムスタンプ秒, 検出結果) を受け取るコールバック
+    using ResultCallback = std::function<void(int cameraId, double timestampSec,
+                                              const std::vector<Rect> &heads)>;
+
+    // batchSize > 0 の場合は1つのInferenceを全カメラで共有し、
+    // 推論をマイクロバッチとしてまとめて実行する
+    explicit CameraIngest(int batchSize = 0);
+    ~CameraIngest();
+
+    // 結果通知コールバックを設定する（addCameraより先に呼ぶこと）
+    void setCallback(ResultCallback callback);
+
+    // カメラを追加し、取り込みスレッドを起動する
+    void addCamera(const CameraConfig &config);
+
+    // カメラの取り込みを停止して削除する
+    void removeCamera(int cameraId);
+
+    // 全カメラの取り込みを停止する
+    void stop();
+
+  private:
+    void cameraLoop(CameraConfig config,
+                    std::shared_ptr<std::atomic<bool>> stopFlag);
+
+    struct CameraWorker
+    {
+        std::thread thread;
+        std::shared_ptr<std::atomic<bool>> stopFlag;
+    };
+
+    std::shared_ptr<Inference> sharedInference; // バッチモード時のみ
+    std::shared_ptr<BatchScheduler> scheduler;  // バッチモード時のみ
+    ResultCallback callback;
+    std::mutex mtx;
+    std::map<int, CameraWorker> cameras; // カメラIDごとの取り込みスレッド
+};
+#endif
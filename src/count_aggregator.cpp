@@ -0,0 +1,153 @@
+/*
+ * This file is part of [Head Count Web Application].
+ *
+ * Copyright (C) 2025 TakumiVision co., ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "count_aggregator.h"
+
+#include <algorithm>
+#include <chrono>
+
+// 現在時刻をUNIXミリ秒で返す
+static uint64_t nowMs()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+CountAggregator &CountAggregator::instance()
+{
+    static CountAggregator aggregator;
+    return aggregator;
+}
+
+CountAggregator::CameraRing *CountAggregator::ringFor(int cameraId, bool create)
+{
+    if (cameraId < 0 || cameraId >= maxCameras) {
+        return nullptr;
+    }
+    CameraRing *ring = rings[cameraId].load(std::memory_order_acquire);
+    if (ring || !create) {
+        return ring;
+    }
+
+    // 初回のみ：生成をミューテックスで直列化する（以降はロックフリー）
+    std::lock_guard<std::mutex> lock(registryMtx);
+    ring = rings[cameraId].load(std::memory_order_acquire);
+    if (!ring) {
+        ring = new CameraRing();
+        rings[cameraId].store(ring, std::memory_order_release);
+    }
+    return ring;
+}
+
+void CountAggregator::record(int cameraId, int count)
+{
+    CameraRing *ring = ringFor(cameraId, true);
+    if (!ring) {
+        return;
+    }
+
+    uint64_t clamped =
+        (uint64_t)std::max(0, std::min(count, (int)countMask));
+    uint64_t packed = (nowMs() << countBits) | clamped;
+
+    // 通し番号を取ってからストアするため、読み手が未書き込みのスロット
+    // （値0）を見ることがある。読み出し側は0を空として読み飛ばす
+    uint64_t seq = ring->head.fetch_add(1, std::memory_order_relaxed);
+    ring->slots[seq & (ringSlots - 1)].store(packed,
+                                             std::memory_order_release);
+}
+
+int CountAggregator::currentCount(int cameraId)
+{
+    CameraRing *ring = ringFor(cameraId, false);
+    if (!ring) {
+        return -1;
+    }
+    uint64_t head = ring->head.load(std::memory_order_acquire);
+    if (head == 0) {
+        return -1;
+    }
+    uint64_t packed =
+        ring->slots[(head - 1) & (ringSlots - 1)].load(std::memory_order_acquire);
+    if (packed == 0) {
+        return -1; // 書き込み中：通し番号は進んだがストア前
+    }
+    return (int)(packed & countMask);
+}
+
+bool CountAggregator::windowStats(int cameraId, double seconds, int *minCount,
+                                  int *maxCount, double *mean)
+{
+    CameraRing *ring = ringFor(cameraId, false);
+    if (!ring) {
+        return false;
+    }
+    uint64_t head = ring->head.load(std::memory_order_acquire);
+    if (head == 0) {
+        return false;
+    }
+
+    uint64_t now = nowMs();
+    uint64_t windowMs = (uint64_t)(seconds * 1000.0);
+    uint64_t cutoff = windowMs < now ? now - windowMs : 0;
+
+    // 最新のサンプルから過去へ向かって、窓から出るまで走査する。
+    // 各スロットは単一のアトミック値なので裂けた読み出しはない。
+    // 走査中に書き手に1周追い付かれたスロットはタイムスタンプが
+    // 逆行（増加）するので、そこで打ち切る
+    int lo = 0;
+    int hi = 0;
+    uint64_t sum = 0;
+    uint64_t n = 0;
+    uint64_t prevTs = ~0ull;
+    uint64_t scanned = std::min(head, (uint64_t)ringSlots);
+    for (uint64_t i = 0; i < scanned; ++i) {
+        uint64_t packed = ring->slots[(head - 1 - i) & (ringSlots - 1)].load(
+            std::memory_order_acquire);
+        if (packed == 0) {
+            continue; // 未書き込みのスロット
+        }
+        uint64_t ts = packed >> countBits;
+        if (ts < cutoff || ts > prevTs) {
+            break;
+        }
+        prevTs = ts;
+
+        int count = (int)(packed & countMask);
+        if (n == 0) {
+            lo = count;
+            hi = count;
+        }
+        else {
+            lo = std::min(lo, count);
+            hi = std::max(hi, count);
+        }
+        sum += (uint64_t)count;
+        ++n;
+    }
+
+    if (n == 0) {
+        return false;
+    }
+    *minCount = lo;
+    *maxCount = hi;
+    *mean = (double)sum / (double)n;
+    return true;
+}
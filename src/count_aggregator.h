@@ -0,0 +1,74 @@
+/*
+ * This file is part of [Head Count Web Application].
+ *
+ * Copyright (C) 2025 TakumiVision co., ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __COUNT_AGGREGATOR_H__
+#define __COUNT_AGGREGATOR_H__
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+// カメラごとの人数集計レジストリ
+// 検出経路が（タイムスタンプ, 人数）のサンプルをカメラごとの
+// 固定長リングへ書き込む。書き込みはアトミックストア1回のみで
+// ロックを取らない（リングの生成時のみミューテックスで保護する）。
+// ダッシュボードは現在人数をO(1)で、直近N秒の最小・最大・平均を
+// リング1周以内の走査で取得できる
+class CountAggregator
+{
+  public:
+    // 対応するカメラIDの上限（0〜maxCameras-1）
+    static constexpr int maxCameras = 256;
+
+    // カメラあたりのサンプル数（2のべき乗）。5fpsの検出で約3.4分ぶん
+    static constexpr size_t ringSlots = 1024;
+
+    static CountAggregator &instance();
+
+    // サンプルを記録する（ホットパス：ロックフリー）
+    // 範囲外のcameraIdは無視する
+    void record(int cameraId, int count);
+
+    // 最新の人数を返す。サンプルがなければ-1
+    int currentCount(int cameraId);
+
+    // 直近seconds秒の最小・最大・平均を求める。
+    // サンプルがなければfalseを返す
+    bool windowStats(int cameraId, double seconds, int *minCount,
+                     int *maxCount, double *mean);
+
+  private:
+    // 1サンプルを64bitへパックしてアトミックに格納する：
+    // 上位44bitがUNIXミリ秒、下位20bitが人数（読み出しで裂けない）
+    static constexpr int countBits = 20;
+    static constexpr uint64_t countMask = (1ull << countBits) - 1;
+
+    struct CameraRing
+    {
+        std::atomic<uint64_t> head{0}; // 次に書き込む通し番号
+        std::array<std::atomic<uint64_t>, ringSlots> slots{};
+    };
+
+    // カメラのリングを取得する。createがtrueなら必要に応じて生成する
+    CameraRing *ringFor(int cameraId, bool create);
+
+    std::mutex registryMtx; // リング生成時のみ使用
+    std::array<std::atomic<CameraRing *>, maxCameras> rings{};
+};
+#endif
@@ -0,0 +1,92 @@
+/*
+ * This file is part of [Head Count Web Application].
+ *
+ * Copyright (C) 2025 TakumiVision co., ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "device_scheduler.h"
+
+#include <stdexcept>
+
+#include <spdlog/spdlog.h>
+
+DeviceScheduler::DeviceScheduler(const std::vector<int> &deviceIds,
+                                 int replicasPerDevice,
+                                 InferenceFactory factory)
+{
+    if (replicasPerDevice < 1) {
+        replicasPerDevice = 1;
+    }
+
+    for (int deviceId : deviceIds) {
+        for (int i = 0; i < replicasPerDevice; ++i) {
+            try {
+                auto replica = std::make_unique<Replica>();
+                replica->inf = factory(deviceId);
+                replica->deviceId = deviceId;
+                replicas.push_back(std::move(replica));
+            }
+            catch (const std::exception &e) {
+                // 切り離されたGPU等：そのデバイスを飛ばして続行する
+                spdlog::warn(
+                    "DeviceScheduler: failed to create replica on device {} "
+                    "({}); skipping",
+                    deviceId, e.what());
+                break;
+            }
+        }
+    }
+
+    if (replicas.empty()) {
+        throw std::runtime_error(
+            "DeviceScheduler: no inference replica could be created");
+    }
+    spdlog::info("DeviceScheduler: {} replicas across {} requested devices",
+                 replicas.size(), deviceIds.size());
+}
+
+Inference *DeviceScheduler::acquire(size_t *replicaIndex)
+{
+    // 実行中リクエスト数が最小のレプリカを選ぶ。厳密な最小である必要は
+    // なく（選択とインクリメントの間に他スレッドが入りうる）、負荷の
+    // 偏りを十分に抑えられればよい
+    size_t best = 0;
+    int bestLoad = replicas[0]->inFlight.load(std::memory_order_relaxed);
+    for (size_t i = 1; i < replicas.size(); ++i) {
+        int load = replicas[i]->inFlight.load(std::memory_order_relaxed);
+        if (load < bestLoad) {
+            bestLoad = load;
+            best = i;
+        }
+    }
+    replicas[best]->inFlight.fetch_add(1, std::memory_order_relaxed);
+    // Inferenceのスクラッチバッファはスレッド間で共有できないため、
+    // 返却までレプリカを占有する（全レプリカ使用中なら空くまで待つ）
+    replicas[best]->busy.lock();
+    *replicaIndex = best;
+    return replicas[best]->inf.get();
+}
+
+void DeviceScheduler::release(size_t replicaIndex)
+{
+    replicas[replicaIndex]->busy.unlock();
+    replicas[replicaIndex]->inFlight.fetch_sub(1, std::memory_order_relaxed);
+}
+
+std::shared_ptr<Inference> DeviceScheduler::replicaInference(size_t index) const
+{
+    return replicas[index]->inf;
+}
@@ -0,0 +1,72 @@
+/*
+ * This file is part of [Head Count Web Application].
+ *
+ * Copyright (C) 2025 TakumiVision co., ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __DEVICE_SCHEDULER_H__
+#define __DEVICE_SCHEDULER_H__
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "inference.h"
+
+// マルチGPUディスパッチャ
+// GPUごとに1つ以上のInferenceレプリカを保持し、デバイスごとの実行中
+// リクエスト数を追跡して、最も空いているレプリカへ推論を振り分ける。
+// レプリカの生成に失敗したデバイス（メンテナンスで切り離された等）は
+// 警告を出してスキップし、残りのデバイスで動作を続ける
+class DeviceScheduler
+{
+  public:
+    // deviceIdで指定したCUDAデバイスにInferenceを生成するファクトリ
+    using InferenceFactory = std::function<std::shared_ptr<Inference>(int)>;
+
+    // 各デバイスにreplicasPerDevice個のレプリカを生成する。
+    // 1つもレプリカを生成できなかった場合はstd::runtime_errorを送出する
+    DeviceScheduler(const std::vector<int> &deviceIds, int replicasPerDevice,
+                    InferenceFactory factory);
+
+    // 最も空いているレプリカを確保する。Inferenceはスレッド間で共有できない
+    // ため、レプリカは返却まで呼び出し元が占有する（全レプリカ使用中の場合
+    // は空くまでブロックする）。使用後は必ずrelease()で返すこと
+    Inference *acquire(size_t *replicaIndex);
+    void release(size_t replicaIndex);
+
+    // レプリカのInferenceを返す（PersonCounterの既定Inference共有用）
+    std::shared_ptr<Inference> replicaInference(size_t index) const;
+
+    size_t replicaCount() const
+    {
+        return replicas.size();
+    }
+
+  private:
+    struct Replica
+    {
+        std::shared_ptr<Inference> inf;
+        int deviceId;
+        std::atomic<int> inFlight{0};
+        std::mutex busy; // レプリカ占有用（Inferenceはスレッド非対応）
+    };
+
+    // atomicメンバを持つためvector<unique_ptr>で保持する
+    std::vector<std::unique_ptr<Replica>> replicas;
+};
+#endif
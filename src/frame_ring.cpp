@@ -0,0 +1,221 @@
+/*
+ * This file is part of [Head Count Web Application].
+ *
+ * Copyright (C) 2025 TakumiVision co., ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "frame_ring.h"
+
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+namespace
+{
+constexpr uint32_t ringMagic = 0x46524e47; // "FRNG"
+
+// 共有メモリの先頭に置かれるリングヘッダ。プロデューサ・コンシューマの
+// 双方のプロセスから同じレイアウトで参照される
+struct RingHeader
+{
+    uint32_t magic;
+    uint32_t slotCount;
+    uint64_t slotSize;
+    std::atomic<uint64_t> head; // 次に書き込むスロットの通し番号
+};
+
+// 各スロットの先頭に置かれるヘッダ（64バイト境界へ整列）
+struct alignas(64) SlotHeader
+{
+    std::atomic<uint32_t> sequence; // seqlock：奇数は書き込み中
+    uint32_t format;
+    uint32_t width;
+    uint32_t height;
+    uint64_t size;
+};
+
+size_t roundUpPow2(size_t n)
+{
+    size_t p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+} // namespace
+
+FrameRing::FrameRing(const std::string &name, size_t slotCount, size_t slotSize,
+                     bool create)
+{
+    shmName = name.empty() || name[0] != '/' ? "/" + name : name;
+    numSlots = roundUpPow2(slotCount < 1 ? 1 : slotCount);
+    payloadCapacity = slotSize;
+    owner = create;
+
+    if (create) {
+        // 既存の残骸があれば作り直す
+        shm_unlink(shmName.c_str());
+        fd = shm_open(shmName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0666);
+        if (fd < 0) {
+            throw std::runtime_error("FrameRing: shm_open failed for "
+                                     + shmName);
+        }
+        mapSize = sizeof(RingHeader)
+                  + numSlots * (sizeof(SlotHeader) + payloadCapacity);
+        if (ftruncate(fd, (off_t)mapSize) != 0) {
+            close(fd);
+            shm_unlink(shmName.c_str());
+            throw std::runtime_error("FrameRing: ftruncate failed for "
+                                     + shmName);
+        }
+    }
+    else {
+        fd = shm_open(shmName.c_str(), O_RDWR, 0666);
+        if (fd < 0) {
+            throw std::runtime_error("FrameRing: shm_open failed for "
+                                     + shmName);
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            throw std::runtime_error("FrameRing: fstat failed for " + shmName);
+        }
+        mapSize = (size_t)st.st_size;
+    }
+
+    base = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        if (owner) {
+            shm_unlink(shmName.c_str());
+        }
+        base = nullptr;
+        throw std::runtime_error("FrameRing: mmap failed for " + shmName);
+    }
+
+    RingHeader *header = (RingHeader *)base;
+    if (create) {
+        std::memset(base, 0, mapSize);
+        header->magic = ringMagic;
+        header->slotCount = (uint32_t)numSlots;
+        header->slotSize = payloadCapacity;
+        header->head.store(0, std::memory_order_relaxed);
+        spdlog::info("FrameRing {}: created ({} slots x {} bytes)", shmName,
+                     numSlots, payloadCapacity);
+    }
+    else {
+        if (header->magic != ringMagic) {
+            munmap(base, mapSize);
+            close(fd);
+            base = nullptr;
+            throw std::runtime_error("FrameRing: " + shmName
+                                     + " is not a frame ring");
+        }
+        numSlots = header->slotCount;
+        payloadCapacity = header->slotSize;
+        spdlog::info("FrameRing {}: attached ({} slots x {} bytes)", shmName,
+                     numSlots, payloadCapacity);
+    }
+}
+
+FrameRing::~FrameRing()
+{
+    if (base) {
+        munmap(base, mapSize);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (owner) {
+        shm_unlink(shmName.c_str());
+    }
+}
+
+size_t FrameRing::slotCount() const
+{
+    return numSlots;
+}
+
+size_t FrameRing::slotSize() const
+{
+    return payloadCapacity;
+}
+
+void *FrameRing::slotHeaderAt(uint64_t slotIndex) const
+{
+    size_t slot = (size_t)(slotIndex & (numSlots - 1));
+    return (char *)base + sizeof(RingHeader)
+           + slot * (sizeof(SlotHeader) + payloadCapacity);
+}
+
+uint64_t FrameRing::write(const unsigned char *data, size_t size, int format,
+                          int width, int height)
+{
+    if (size > payloadCapacity) {
+        throw std::runtime_error("FrameRing: payload exceeds slot size");
+    }
+
+    RingHeader *header = (RingHeader *)base;
+    uint64_t index = header->head.fetch_add(1, std::memory_order_relaxed);
+    SlotHeader *slot = (SlotHeader *)slotHeaderAt(index);
+    unsigned char *payload = (unsigned char *)(slot + 1);
+
+    // seqlock：奇数にして書き込み開始を知らせ、書き終えたら偶数へ戻す
+    uint32_t seq = slot->sequence.load(std::memory_order_relaxed);
+    slot->sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot->format = (uint32_t)format;
+    slot->width = (uint32_t)width;
+    slot->height = (uint32_t)height;
+    slot->size = size;
+    std::memcpy(payload, data, size);
+
+    slot->sequence.store(seq + 2, std::memory_order_release);
+    return index & (numSlots - 1);
+}
+
+bool FrameRing::beginRead(uint64_t slotIndex, FrameView *view) const
+{
+    const SlotHeader *slot = (const SlotHeader *)slotHeaderAt(slotIndex);
+
+    uint32_t seq = slot->sequence.load(std::memory_order_acquire);
+    if (seq & 1) {
+        return false; // 書き込み中
+    }
+
+    view->data = (const unsigned char *)(slot + 1);
+    view->size = (size_t)slot->size;
+    view->format = (int)slot->format;
+    view->width = (int)slot->width;
+    view->height = (int)slot->height;
+    view->sequence = seq;
+    return view->size > 0;
+}
+
+bool FrameRing::stillValid(uint64_t slotIndex, uint32_t sequence) const
+{
+    const SlotHeader *slot = (const SlotHeader *)slotHeaderAt(slotIndex);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot->sequence.load(std::memory_order_acquire) == sequence;
+}
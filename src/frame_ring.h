@@ -0,0 +1,92 @@
+/*
+ * This file is part of [Head Count Web Application].
+ *
+ * Copyright (C) 2025 TakumiVision co., ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __FRAME_RING_H__
+#define __FRAME_RING_H__
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 共有メモリ上のフレームリングバッファ
+// 同一ホストのプロデューサ（グラバ等）がHTTPやPythonヒープを経由せずに
+// フレームを検出側へ渡すためのトランスポート。POSIX共有メモリ
+// （shm_open/mmap）上に固定数（2のべき乗）のスロットを持ち、スロットごとの
+// seqlockで書き込みと読み出しを調停する。ロックは取らないため、読み出し中に
+// プロデューサが同じスロットへ追い付いて上書きした場合は、シーケンス番号の
+// 不一致として検出し読み直す
+class FrameRing
+{
+  public:
+    // スロットに格納されるペイロード形式
+    static constexpr int FormatJPEG = 0; // JPEGバイト列
+    static constexpr int FormatBGR = 1;  // BGR 8bit 3chの生フレーム
+
+    // 読み出し中スロットのビュー（共有メモリを直接指す。コピーなし）
+    struct FrameView
+    {
+        const unsigned char *data; // ペイロード先頭（共有メモリ内）
+        size_t size;               // ペイロードのバイト数
+        int format;                // FormatJPEG / FormatBGR
+        int width;                 // FormatBGR時の幅
+        int height;                // FormatBGR時の高さ
+        uint32_t sequence;         // 読み出し開始時のシーケンス番号
+    };
+
+    // create=trueで共有メモリを新規作成（既存があれば作り直す）、
+    // falseで既存のリングへ接続する。slotCountは2のべき乗へ切り上げられる。
+    // 失敗時はstd::runtime_errorを送出する
+    FrameRing(const std::string &name, size_t slotCount = 8,
+              size_t slotSize = 4u << 20, bool create = true);
+    ~FrameRing();
+
+    FrameRing(const FrameRing &) = delete;
+    FrameRing &operator=(const FrameRing &) = delete;
+
+    size_t slotCount() const;
+    size_t slotSize() const;
+    const std::string &name() const
+    {
+        return shmName;
+    }
+
+    // プロデューサ：次のスロットへペイロードを書き込み、
+    // 書き込んだスロット番号を返す
+    uint64_t write(const unsigned char *data, size_t size, int format,
+                   int width = 0, int height = 0);
+
+    // コンシューマ：スロットの読み出しを開始する。
+    // 書き込み中の場合はfalseを返す。読み出し完了後はstillValid()で
+    // 上書きされていないことを確認すること
+    bool beginRead(uint64_t slotIndex, FrameView *view) const;
+
+    // beginRead以降にスロットが上書きされていなければtrue
+    bool stillValid(uint64_t slotIndex, uint32_t sequence) const;
+
+  private:
+    void *slotHeaderAt(uint64_t slotIndex) const;
+
+    std::string shmName; // 共有メモリ名（"/"始まり）
+    int fd = -1;
+    void *base = nullptr; // マップ先頭（リングヘッダ）
+    size_t mapSize = 0;
+    size_t numSlots = 0;
+    size_t payloadCapacity = 0;
+    bool owner = false; // 作成者はデストラクタでshm_unlinkする
+};
+#endif
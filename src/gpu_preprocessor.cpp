@@ -0,0 +1,80 @@
+/*
+ * This file is part of [Head Count Web Application].
+ *
+ * Copyright (C) 2025 TakumiVision co., ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "gpu_preprocessor.h"
+
+#ifdef WITH_CUDA_PREPROC
+
+#include <algorithm>
+
+GpuPreprocessor::GpuPreprocessor(const cv::Size &modelInputShape)
+    : modelShape(modelInputShape)
+{
+    int w = modelShape.width;
+    int h = modelShape.height;
+    canvas.create(h, w, CV_8UC3);
+    rgbCanvas.create(h, w, CV_8UC3);
+    floatCanvas.create(h, w, CV_32FC3);
+    blobDev.create(1, 3 * h * w, CV_32F);
+    pinnedBlob = cv::cuda::HostMem(1, 3 * h * w, CV_32F,
+                                   cv::cuda::HostMem::PAGE_LOCKED);
+}
+
+cv::Mat GpuPreprocessor::makeBlob(const cv::Mat &frame, int *pad_x, int *pad_y,
+                                  float *scale)
+{
+    int w = modelShape.width;
+    int h = modelShape.height;
+
+    *scale = std::min(w / (float)frame.cols, h / (float)frame.rows);
+    int resized_w = frame.cols * *scale;
+    int resized_h = frame.rows * *scale;
+    *pad_x = (w - resized_w) / 2;
+    *pad_y = (h - resized_h) / 2;
+
+    frameDev.upload(frame, stream);
+
+    canvas.setTo(cv::Scalar(), stream);
+    cv::cuda::GpuMat target =
+        canvas(cv::Rect(*pad_x, *pad_y, resized_w, resized_h));
+    cv::cuda::resize(frameDev, target, cv::Size(resized_w, resized_h), 0, 0,
+                     cv::INTER_LINEAR, stream);
+
+    cv::cuda::cvtColor(canvas, rgbCanvas, cv::COLOR_BGR2RGB, 0, stream);
+    rgbCanvas.convertTo(floatCanvas, CV_32FC3, 1.0 / 255.0, stream);
+
+    // Planarize into the contiguous device blob (NCHW, batch 1)
+    size_t planeStep = (size_t)w * sizeof(float);
+    cv::cuda::GpuMat planes[3] = {
+        cv::cuda::GpuMat(h, w, CV_32F, blobDev.ptr<float>(), planeStep),
+        cv::cuda::GpuMat(h, w, CV_32F, blobDev.ptr<float>() + (size_t)h * w,
+                         planeStep),
+        cv::cuda::GpuMat(h, w, CV_32F, blobDev.ptr<float>() + 2 * (size_t)h * w,
+                         planeStep)};
+    cv::cuda::split(floatCanvas, planes, stream);
+
+    // Stage only the finished blob back to the host, through pinned memory
+    blobDev.download(pinnedBlob, stream);
+    stream.waitForCompletion();
+
+    int blobDims[4] = {1, 3, h, w};
+    return cv::Mat(4, blobDims, CV_32F, pinnedBlob.createMatHeader().data);
+}
+
+#endif // WITH_CUDA_PREPROC
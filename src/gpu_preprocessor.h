@@ -0,0 +1,56 @@
+/*
+ * This file is part of [Head Count Web Application].
+ *
+ * Copyright (C) 2025 TakumiVision co., ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GPU_PREPROCESSOR_H__
+#define __GPU_PREPROCESSOR_H__
+
+#ifdef WITH_CUDA_PREPROC
+#include <opencv2/opencv.hpp>
+#include <opencv2/core/cuda.hpp>
+#include <opencv2/cudaarithm.hpp>
+#include <opencv2/cudaimgproc.hpp>
+#include <opencv2/cudawarping.hpp>
+
+// Device-resident preprocessing: the frame is uploaded once, then resize,
+// letterbox fill, BGR->RGB conversion, normalization and NCHW planarization
+// all run on the GPU. Only the finished blob (a few MB at 640x640) is staged
+// back through pinned memory for cv::dnn, which still consumes a host blob.
+// All device and pinned buffers are allocated once and reused across frames.
+class GpuPreprocessor
+{
+  public:
+    explicit GpuPreprocessor(const cv::Size &modelInputShape);
+
+    // Build the NCHW float blob for one frame. Returns a Mat header over the
+    // pinned staging buffer; valid until the next makeBlob call.
+    cv::Mat makeBlob(const cv::Mat &frame, int *pad_x, int *pad_y, float *scale);
+
+  private:
+    cv::Size modelShape;
+    cv::cuda::GpuMat frameDev;   // uploaded input frame
+    cv::cuda::GpuMat canvas;     // letterbox canvas (8UC3)
+    cv::cuda::GpuMat rgbCanvas;  // canvas after BGR->RGB
+    cv::cuda::GpuMat floatCanvas; // normalized float canvas
+    cv::cuda::GpuMat blobDev;    // contiguous NCHW device blob
+    cv::cuda::HostMem pinnedBlob; // page-locked staging buffer
+    cv::cuda::Stream stream;
+};
+#endif // WITH_CUDA_PREPROC
+
+#endif
@@ -0,0 +1,175 @@
+/*
+ * This file is part of [Head Count Web Application].
+ *
+ * Copyright (C) 2025 TakumiVision co., ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "head_tracker.h"
+
+#include <algorithm>
+
+namespace
+{
+// トラックと検出ボックスのIoU
+float trackIou(float tx, float ty, float tw, float th, const Rect &d)
+{
+    float ix1 = std::max(tx, (float)d.x);
+    float iy1 = std::max(ty, (float)d.y);
+    float ix2 = std::min(tx + tw, (float)(d.x + d.width));
+    float iy2 = std::min(ty + th, (float)(d.y + d.height));
+    float iw = ix2 - ix1;
+    float ih = iy2 - iy1;
+    if (iw <= 0 || ih <= 0) {
+        return 0.0f;
+    }
+    float inter = iw * ih;
+    float uni = tw * th + (float)d.width * (float)d.height - inter;
+    return uni > 0 ? inter / uni : 0.0f;
+}
+} // namespace
+
+HeadTracker::HeadTracker(int detectEvery_, float iouThreshold_, int maxMissed_)
+    : detectEvery(detectEvery_ < 1 ? 1 : detectEvery_),
+      iouThreshold(iouThreshold_), maxMissed(maxMissed_)
+{
+}
+
+bool HeadTracker::needsDetection(int cameraId)
+{
+    CameraState &state = cameras[cameraId];
+    bool due = (state.frameCount % detectEvery) == 0;
+    ++state.frameCount;
+    return due;
+}
+
+std::vector<Rect> HeadTracker::update(int cameraId,
+                                      const std::vector<Rect> &detections)
+{
+    CameraState &state = cameras[cameraId];
+    std::vector<bool> detMatched(detections.size(), false);
+
+    for (auto &&track : state.tracks) {
+        track.matched = false;
+    }
+
+    // トラックごとに最良IoUの未対応検出を貪欲に対応付ける
+    for (auto &&track : state.tracks) {
+        float bestIou = iouThreshold;
+        int bestIdx = -1;
+        for (size_t i = 0; i < detections.size(); ++i) {
+            if (detMatched[i]) {
+                continue;
+            }
+            float v = trackIou(track.x, track.y, track.w, track.h,
+                               detections[i]);
+            if (v > bestIou) {
+                bestIou = v;
+                bestIdx = (int)i;
+            }
+        }
+        if (bestIdx < 0) {
+            continue;
+        }
+
+        const Rect &d = detections[bestIdx];
+        // 速度は指数平滑して更新（単発のジッタに引きずられないように）
+        track.vx = 0.5f * track.vx + 0.5f * ((float)d.x - track.x);
+        track.vy = 0.5f * track.vy + 0.5f * ((float)d.y - track.y);
+        track.x = (float)d.x;
+        track.y = (float)d.y;
+        track.w = (float)d.width;
+        track.h = (float)d.height;
+        track.confidence = d.confidence;
+        track.missed = 0;
+        track.matched = true;
+        detMatched[bestIdx] = true;
+    }
+
+    // 未対応トラックは未対応回数を進め、上限を超えたら破棄する
+    state.tracks.erase(
+        std::remove_if(state.tracks.begin(), state.tracks.end(),
+                       [&](Track &track) {
+                           if (!track.matched) {
+                               ++track.missed;
+                           }
+                           return track.missed > maxMissed;
+                       }),
+        state.tracks.end());
+
+    // 未対応の検出から新規トラックを起こす
+    for (size_t i = 0; i < detections.size(); ++i) {
+        if (detMatched[i]) {
+            continue;
+        }
+        const Rect &d = detections[i];
+        Track track;
+        track.x = (float)d.x;
+        track.y = (float)d.y;
+        track.w = (float)d.width;
+        track.h = (float)d.height;
+        track.vx = 0.0f;
+        track.vy = 0.0f;
+        track.confidence = d.confidence;
+        track.id = state.nextId++;
+        track.missed = 0;
+        track.matched = true;
+        state.tracks.push_back(track);
+    }
+
+    // 生存中の全トラックを出力する。検出と対応したトラックは検出位置、
+    // 未対応のトラックは等速度モデルで1フレーム分外挿した橋渡し位置
+    // （tracked = true）。predict()と同じ集合を返すことで、単発の
+    // 見逃しや退場で出力が検出フレームと外挿フレームの間で波打たない
+    std::vector<Rect> results;
+    results.reserve(state.tracks.size());
+    for (auto &&track : state.tracks) {
+        if (!track.matched) {
+            track.x += track.vx;
+            track.y += track.vy;
+        }
+        Rect r((int)track.x, (int)track.y, (int)track.w, (int)track.h,
+               track.confidence);
+        r.trackId = track.id;
+        r.tracked = !track.matched;
+        results.push_back(r);
+    }
+    return results;
+}
+
+std::vector<Rect> HeadTracker::predict(int cameraId)
+{
+    CameraState &state = cameras[cameraId];
+
+    std::vector<Rect> results;
+    results.reserve(state.tracks.size());
+    for (auto &&track : state.tracks) {
+        // 等速度モデルで1フレーム分外挿する
+        track.x += track.vx;
+        track.y += track.vy;
+
+        Rect r((int)track.x, (int)track.y, (int)track.w, (int)track.h,
+               track.confidence);
+        r.trackId = track.id;
+        r.tracked = true;
+        results.push_back(r);
+    }
+    return results;
+}
+
+void HeadTracker::reset(int cameraId)
+{
+    cameras.erase(cameraId);
+}
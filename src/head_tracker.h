@@ -0,0 +1,78 @@
+/*
+ * This file is part of [Head Count Web Application].
+ *
+ * Copyright (C) 2025 TakumiVision co., ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __HEAD_TRACKER_H__
+#define __HEAD_TRACKER_H__
+#include <map>
+#include <vector>
+
+#include "person_counter.h"
+
+// フレーム間頭部トラッカ（SORT系の簡易版）
+// Nフレームに1回だけ検出を実行し、その間は等速度モデルでボックスを
+// 外挿する。検出フレームではIoUの貪欲マッチングでトラックと検出を
+// 対応付け、安定したトラックIDを付与する。カメラ／ストリームIDごとに
+// 独立した状態を持つ
+class HeadTracker
+{
+  public:
+    HeadTracker(int detectEvery = 5, float iouThreshold = 0.3f,
+                int maxMissed = 3);
+
+    // フレームごとに1回呼ぶ。このフレームで検出を実行すべきならtrue
+    bool needsDetection(int cameraId);
+
+    // 検出フレーム：検出結果をトラックへ対応付けて更新し、
+    // トラックID付きの結果を返す。未対応でも生存中（missed <= maxMissed）
+    // のトラックは外挿位置で出力に含める（tracked = trueの橋渡しボックス。
+    // predict()と同じ集合を返すことで、単発の見逃しで人数が波打たない）
+    std::vector<Rect> update(int cameraId, const std::vector<Rect> &detections);
+
+    // 非検出フレーム：等速度モデルでトラックを1フレーム分進めて返す
+    // （tracked = true）
+    std::vector<Rect> predict(int cameraId);
+
+    // カメラの全トラックを破棄する
+    void reset(int cameraId);
+
+  private:
+    struct Track
+    {
+        float x, y, w, h; // 現在のボックス（左上座標とサイズ）
+        float vx, vy;     // 推定速度（ピクセル/フレーム）
+        float confidence; // 直近の検出信頼度
+        int id;           // トラックID（カメラ内で一意）
+        int missed;       // 連続で検出と対応しなかった回数
+        bool matched;     // 対応付け作業用
+    };
+
+    struct CameraState
+    {
+        std::vector<Track> tracks;
+        int frameCount = 0;
+        int nextId = 1;
+    };
+
+    int detectEvery;    // 検出を実行するフレーム間隔
+    float iouThreshold; // 対応付けに必要な最小IoU
+    int maxMissed;      // この回数を超えて未対応のトラックは破棄
+
+    std::map<int, CameraState> cameras;
+};
+#endif
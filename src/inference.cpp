@@ -2,143 +2,817 @@
 
 #include "inference.h"
 
+#include <algorithm>
+#include <chrono>
+
+#include <opencv2/core/hal/intrin.hpp>
 #include <spdlog/spdlog.h>
 
+// Scan a contiguous score row and collect the indices above threshold.
+// Vectorized with OpenCV's universal intrinsics (SSE/AVX on x86, NEON on
+// ARM); the scalar tail handles the remainder.
+static void scanScoresAboveThreshold(const float *scores, int n, float threshold,
+                                     std::vector<int> &candidates)
+{
+    int i = 0;
+#if CV_SIMD128
+    cv::v_float32x4 vthr = cv::v_setall_f32(threshold);
+    for (; i + 4 <= n; i += 4) {
+        if (cv::v_check_any(cv::v_load(scores + i) > vthr)) {
+            for (int k = 0; k < 4; ++k) {
+                if (scores[i + k] > threshold) {
+                    candidates.push_back(i + k);
+                }
+            }
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        if (scores[i] > threshold) {
+            candidates.push_back(i);
+        }
+    }
+}
+
+// Horizontal max over a contiguous class-score row, returning the argmax.
+// Replaces the per-row cv::minMaxLoc on a temporary 1xN Mat header.
+static float rowMaxScore(const float *scores, int n, int *argmax)
+{
+#if CV_SIMD128
+    if (n >= 8) {
+        cv::v_float32x4 vmax = cv::v_load(scores);
+        int i = 4;
+        for (; i + 4 <= n; i += 4) {
+            vmax = cv::v_max(vmax, cv::v_load(scores + i));
+        }
+        float bestScore = cv::v_reduce_max(vmax);
+        for (; i < n; ++i) {
+            bestScore = std::max(bestScore, scores[i]);
+        }
+        for (int j = 0; j < n; ++j) {
+            if (scores[j] == bestScore) {
+                *argmax = j;
+                break;
+            }
+        }
+        return bestScore;
+    }
+#endif
+    int best = 0;
+    float bestScore = scores[0];
+    for (int i = 1; i < n; ++i) {
+        if (scores[i] > bestScore) {
+            bestScore = scores[i];
+            best = i;
+        }
+    }
+    *argmax = best;
+    return bestScore;
+}
+
+// Decode loop over the (rows, dimensions) candidate matrix, specialized at
+// compile time on the output layout and the class count. NumClasses == 0
+// means "runtime count" and is the fallback for unusual models; for the
+// instantiated common cases the class reduction is unrolled and the layout
+// branches disappear from the per-row loop.
+template <bool YoloV8, int NumClasses>
+static void decodeRowsT(const float *data, int rows, int dimensions,
+                        float scoreThreshold, float confidenceThreshold,
+                        int pad_x, int pad_y, float scale,
+                        std::vector<int> &class_ids,
+                        std::vector<float> &confidences,
+                        std::vector<cv::Rect> &boxes, int runtimeClasses)
+{
+    const int numClasses = NumClasses > 0 ? NumClasses : runtimeClasses;
+
+    for (int i = 0; i < rows; ++i, data += dimensions) {
+        if (!YoloV8) {
+            // yolov5 carries an objectness score before the class scores
+            if (data[4] < confidenceThreshold) {
+                continue;
+            }
+        }
+
+        const float *scores = data + (YoloV8 ? 4 : 5);
+        int class_id = 0;
+        float maxClassScore;
+        if (NumClasses == 1) {
+            maxClassScore = scores[0];
+        }
+        else {
+            maxClassScore = rowMaxScore(scores, numClasses, &class_id);
+        }
+
+        if (maxClassScore > scoreThreshold) {
+            confidences.push_back(YoloV8 ? maxClassScore : data[4]);
+            class_ids.push_back(class_id);
+
+            float x = data[0];
+            float y = data[1];
+            float w = data[2];
+            float h = data[3];
+
+            int left = int((x - 0.5 * w - pad_x) / scale);
+            int top = int((y - 0.5 * h - pad_y) / scale);
+
+            int width = int(w / scale);
+            int height = int(h / scale);
+
+            boxes.push_back(cv::Rect(left, top, width, height));
+        }
+    }
+}
+
+// Pick the decode instantiation for this model; called once, on the first
+// frame, when the output layout becomes known.
+static Inference::DecodeRowsFn selectDecodeRows(bool yolov8, int numClasses)
+{
+    if (yolov8) {
+        if (numClasses == 1) {
+            return &decodeRowsT<true, 1>;
+        }
+        if (numClasses == 80) {
+            return &decodeRowsT<true, 80>;
+        }
+        return &decodeRowsT<true, 0>;
+    }
+    if (numClasses == 80) {
+        return &decodeRowsT<false, 80>;
+    }
+    return &decodeRowsT<false, 0>;
+}
+
 Inference::Inference(const std::string &onnxModelPath,
                      const cv::Size &modelInputShape,
-                     const std::string &classesTxtFile, const bool &runWithCuda)
+                     const std::string &classesTxtFile, const bool &runWithCuda,
+                     const InferenceBackend backendKind,
+                     const InferencePrecision precision,
+                     const std::string &calibrationDir, const int deviceId)
 {
     modelPath = onnxModelPath;
     modelShape = modelInputShape;
+    defaultShape = modelInputShape;
     classesPath = classesTxtFile;
     cudaEnabled = runWithCuda;
-
-    loadOnnxNetwork();
+    backendKindUsed = backendKind;
+    precisionUsed = precision;
+    calibrationDirUsed = calibrationDir;
+    deviceIdUsed = deviceId;
+
+    backend = createBackend(backendKind, modelPath, cudaEnabled, precision,
+                            calibrationDir, deviceId);
+    activeBackend = backend.get();
+#ifdef WITH_CUDA_PREPROC
+    if (cudaEnabled && letterBoxForSquare
+        && modelShape.width == modelShape.height) {
+        gpuPreproc = std::make_unique<GpuPreprocessor>(modelShape);
+        spdlog::info("CUDA preprocessing pipeline enabled");
+    }
+#endif
     // loadClassesFromFile(); The classes are hard-coded for this example
+
+    // Preallocate the hot-path scratch buffers once per instance
+    scratch.canvas =
+        cv::Mat::zeros(modelShape.height, modelShape.width, CV_8UC3);
+    scratch.class_ids.reserve(expectedRows);
+    scratch.confidences.reserve(expectedRows);
+    scratch.boxes.reserve(expectedRows);
+    scratch.nms_result.reserve(expectedRows);
+    scratch.candidates.reserve(expectedRows);
 }
 
-std::vector<Detection> Inference::runInference(const cv::Mat &input)
+Inference::~Inference()
 {
+    waitForWarmup();
+}
+
+void Inference::warmup(int iterations)
+{
+    cv::Mat dummy =
+        cv::Mat::zeros(modelShape.height, modelShape.width, CV_8UC3);
+    for (int i = 0; i < iterations; ++i) {
+        runInference(dummy);
+    }
+    spdlog::info("Warmup complete ({} iterations)", iterations);
+}
+
+// Marks the background warmup thread so its own inference calls skip the
+// warmup synchronization; it must never touch the std::thread handle it runs
+// on, which warmupAsync may still be assigning.
+static thread_local bool inWarmupThread = false;
+
+void Inference::warmupAsync(int iterations)
+{
+    // Assigning over a joinable std::thread terminates the process; a second
+    // background warmup waits for the first one instead
+    waitForWarmup();
+    std::lock_guard<std::mutex> lock(warmupMtx);
+    warmupThread = std::thread([this, iterations] {
+        inWarmupThread = true;
+        warmup(iterations);
+        inWarmupThread = false;
+    });
+}
+
+void Inference::waitForWarmup()
+{
+    // The warmup thread reaches this through runInference and returns here
+    // via its thread-local flag; everyone else serializes on warmupMtx so
+    // the handle is never read while warmupAsync assigns it
+    if (inWarmupThread) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(warmupMtx);
+    if (warmupThread.joinable()) {
+        warmupThread.join();
+    }
+}
+
+void Inference::setAdaptiveShapes(bool enabled, const std::vector<int> &sides,
+                                  int densityPromote)
+{
+    shapeVariants.clear();
+    resetDefaultShape();
+    densityPromoteAt = 0;
+    if (!enabled) {
+        return;
+    }
+
+    std::vector<int> sorted = sides;
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+    for (int side : sorted) {
+        if (side < 32) {
+            continue;
+        }
+        ShapeVariant variant;
+        variant.side = side;
+        if (side != (int)defaultShape.width) {
+            // Import (and shape-infer) the network for this input size once,
+            // up front; switching shapes per frame then costs a pointer swap
+            variant.net = createBackend(backendKindUsed, modelPath, cudaEnabled,
+                                        precisionUsed, calibrationDirUsed,
+                                        deviceIdUsed);
+        }
+        shapeVariants.push_back(std::move(variant));
+    }
+
+    densityPromoteAt = densityPromote;
+    spdlog::info("Adaptive input shapes enabled ({} variants)",
+                 shapeVariants.size());
+}
+
+// Pick the smallest variant whose side covers the request's larger dimension,
+// promoted one step when the previous frame was dense.
+void Inference::selectShapeFor(const cv::Mat &input)
+{
+    int need = std::max(input.cols, input.rows);
+    size_t pick = shapeVariants.size() - 1;
+    for (size_t i = 0; i < shapeVariants.size(); ++i) {
+        if (shapeVariants[i].side >= need) {
+            pick = i;
+            break;
+        }
+    }
+    if (densityPromoteAt > 0 && lastDetectionCount >= densityPromoteAt
+        && pick + 1 < shapeVariants.size()) {
+        ++pick;
+    }
+
+    modelShape =
+        cv::Size2f((float)shapeVariants[pick].side, (float)shapeVariants[pick].side);
+    activeBackend =
+        shapeVariants[pick].net ? shapeVariants[pick].net.get() : backend.get();
+}
+
+void Inference::resetDefaultShape()
+{
+    modelShape = defaultShape;
+    activeBackend = backend.get();
+}
+
+// Preprocess one frame, run the forward pass, and return the 2-D output view
+// with the letterbox parameters. Shared by the single-frame entry points.
+cv::Mat Inference::forwardFrame(const cv::Mat &input, int *pad_x, int *pad_y,
+                                float *scale)
+{
+    // A background warmup shares the scratch buffers with this call; make
+    // sure it has finished before the first real frame touches them
+    waitForWarmup();
+
     cv::Mat modelInput = input;
+    *pad_x = 0;
+    *pad_y = 0;
+    *scale = 1.0f;
+
+    if (!shapeVariants.empty()) {
+        selectShapeFor(input);
+    }
+
+    auto stageStart = std::chrono::steady_clock::now();
+
+    std::vector<cv::Mat> outputs;
+#ifdef WITH_CUDA_PREPROC
+    // The GPU preprocessor is built for the default shape only
+    if (gpuPreproc && modelShape == defaultShape) {
+        // Resize, letterbox, normalization and planarization all run on the
+        // device; only the finished blob is staged back through pinned memory
+        cv::Mat blob = gpuPreproc->makeBlob(modelInput, pad_x, pad_y, scale);
+        auto preprocessDone = std::chrono::steady_clock::now();
+        outputs = activeBackend->forward(blob);
+        auto forwardDone = std::chrono::steady_clock::now();
+        timings.preprocessMs =
+            std::chrono::duration<double, std::milli>(preprocessDone - stageStart)
+                .count();
+        timings.forwardMs =
+            std::chrono::duration<double, std::milli>(forwardDone
+                                                      - preprocessDone)
+                .count();
+        return outputs[0].reshape(1, outputs[0].size[1]);
+    }
+#endif
+    if (letterBoxForSquare && modelShape.width == modelShape.height) {
+        formatToSquare(modelInput, scratch.canvas, pad_x, pad_y, scale);
+        modelInput = scratch.canvas;
+    }
+
+    cv::dnn::blobFromImage(modelInput, scratch.blob, 1.0 / 255.0, modelShape,
+                           cv::Scalar(), true, false);
+    auto preprocessDone = std::chrono::steady_clock::now();
+
+    outputs = activeBackend->forward(scratch.blob);
+    auto forwardDone = std::chrono::steady_clock::now();
+
+    timings.preprocessMs =
+        std::chrono::duration<double, std::milli>(preprocessDone - stageStart)
+            .count();
+    timings.forwardMs =
+        std::chrono::duration<double, std::milli>(forwardDone - preprocessDone)
+            .count();
+
+    // Drop the leading batch dimension so the decode sees a 2-D view
+    return outputs[0].reshape(1, outputs[0].size[1]);
+}
+
+std::vector<Detection> Inference::runInference(const cv::Mat &input)
+{
     int pad_x, pad_y;
     float scale;
-    if (letterBoxForSquare && modelShape.width == modelShape.height) {
-        modelInput = formatToSquare(modelInput, &pad_x, &pad_y, &scale);
+    cv::Mat output = forwardFrame(input, &pad_x, &pad_y, &scale);
+    return decodeOutput(output, pad_x, pad_y, scale);
+}
+
+std::vector<Detection> Inference::runInference(const cv::Mat &input,
+                                               const cv::Rect &roi)
+{
+    // A Mat ROI is just a header over the parent frame; formatToSquare
+    // resizes straight from the view into the letterbox canvas, so the ROI
+    // is never materialized as its own copy.
+    return runInference(input(roi));
+}
+
+std::vector<std::vector<Detection>> Inference::runInferenceBatch(
+    const std::vector<cv::Mat> &inputs)
+{
+    std::vector<std::vector<Detection>> results(inputs.size());
+    if (inputs.empty()) {
+        return results;
     }
 
-    cv::Mat blob;
-    cv::dnn::blobFromImage(modelInput, blob, 1.0 / 255.0, modelShape, cv::Scalar(),
-                           true, false);
-    net.setInput(blob);
+    // Serialize against a still-running background warmup (shared scratch)
+    waitForWarmup();
 
-    std::vector<cv::Mat> outputs;
-    net.forward(outputs, net.getUnconnectedOutLayersNames());
+    // Micro-batches mix ROIs from several cameras; run them all through the
+    // default-shape network rather than resolving a shape per slot
+    if (!shapeVariants.empty()) {
+        resetDefaultShape();
+    }
 
-    int rows = outputs[0].size[1];
-    int dimensions = outputs[0].size[2];
+    // Grow the per-slot canvas pool once; slots are reused across batches
+    while (scratch.batchCanvases.size() < inputs.size()) {
+        scratch.batchCanvases.push_back(
+            cv::Mat::zeros(modelShape.height, modelShape.width, CV_8UC3));
+    }
 
-    bool yolov8 = false;
-    // yolov5 has an output of shape (batchSize, 25200, 85) (Num classes +
-    // box[x,y,w,h] + confidence[c]) yolov8 has an output of shape (batchSize,
-    // 84,  8400) (Num classes + box[x,y,w,h])
-    if (dimensions > rows) // Check if the shape[2] is more than shape[1] (yolov8)
-    {
-        yolov8 = true;
-        rows = outputs[0].size[2];
-        dimensions = outputs[0].size[1];
+    std::vector<cv::Mat> modelInputs;
+    modelInputs.reserve(inputs.size());
+    std::vector<int> pad_xs(inputs.size(), 0);
+    std::vector<int> pad_ys(inputs.size(), 0);
+    std::vector<float> scales(inputs.size(), 1.0f);
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        cv::Mat modelInput = inputs[i];
+        if (letterBoxForSquare && modelShape.width == modelShape.height) {
+            formatToSquare(modelInput, scratch.batchCanvases[i], &pad_xs[i],
+                           &pad_ys[i], &scales[i]);
+            modelInput = scratch.batchCanvases[i];
+        }
+        modelInputs.push_back(modelInput);
+    }
+
+    // One N-image blob and a single forward pass; the per-call dispatch
+    // overhead is paid once for the whole batch.
+    cv::dnn::blobFromImages(modelInputs, scratch.blob, 1.0 / 255.0, modelShape,
+                            cv::Scalar(), true, false);
+
+    std::vector<cv::Mat> outputs = backend->forward(scratch.blob);
 
-        outputs[0] = outputs[0].reshape(1, dimensions);
-        cv::transpose(outputs[0], outputs[0]);
+    // outputs[0] has shape (batchSize, d1, d2); demux one 2-D slice per image
+    int d1 = outputs[0].size[1];
+    int d2 = outputs[0].size[2];
+    size_t stride = (size_t)d1 * (size_t)d2;
+    float *base = (float *)outputs[0].data;
+
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        cv::Mat slice(d1, d2, CV_32FC1, base + i * stride);
+        results[i] = decodeOutput(slice, pad_xs[i], pad_ys[i], scales[i]);
     }
-    float *data = (float *)outputs[0].data;
 
-    std::vector<int> class_ids;
-    std::vector<float> confidences;
-    std::vector<cv::Rect> boxes;
+    return results;
+}
 
-    for (int i = 0; i < rows; ++i) {
-        if (yolov8) {
-            float *classes_scores = data + 4;
+std::vector<Detection> Inference::runInferenceTiled(const cv::Mat &input,
+                                                    const cv::Rect &roi,
+                                                    float overlap)
+{
+    return runInferenceTiled(input(roi), overlap);
+}
 
-            cv::Mat scores(1, classes.size(), CV_32FC1, classes_scores);
-            cv::Point class_id;
-            double maxClassScore;
+std::vector<Detection> Inference::runInferenceTiled(const cv::Mat &input,
+                                                    float overlap)
+{
+    // Serialize against a still-running background warmup (shared scratch)
+    waitForWarmup();
 
-            minMaxLoc(scores, 0, &maxClassScore, 0, &class_id);
+    // Tiling exists to keep native resolution; always use the default shape
+    if (!shapeVariants.empty()) {
+        resetDefaultShape();
+    }
 
-            if (maxClassScore > modelScoreThreshold) {
-                confidences.push_back(maxClassScore);
-                class_ids.push_back(class_id.x);
+    int tileW = (int)modelShape.width;
+    int tileH = (int)modelShape.height;
 
-                float x = data[0];
-                float y = data[1];
-                float w = data[2];
-                float h = data[3];
+    // Inputs no larger than one tile gain nothing from tiling
+    if (input.cols <= tileW && input.rows <= tileH) {
+        return runInference(input);
+    }
 
-                int left = int((x - 0.5 * w - pad_x) / scale);
-                int top = int((y - 0.5 * h - pad_y) / scale);
+    // Build the tile grid. Tiles overlap so a head straddling a seam appears
+    // whole in at least one tile, and edge tiles are shifted inward so every
+    // tile keeps the native model resolution (scale 1, no letterboxing).
+    int strideX = std::max(1, (int)(tileW * (1.0f - overlap)));
+    int strideY = std::max(1, (int)(tileH * (1.0f - overlap)));
+
+    std::vector<cv::Rect> tiles;
+    for (int y = 0;; y += strideY) {
+        int ty = std::min(y, std::max(0, input.rows - tileH));
+        for (int x = 0;; x += strideX) {
+            int tx = std::min(x, std::max(0, input.cols - tileW));
+            tiles.push_back(cv::Rect(tx, ty, std::min(tileW, input.cols),
+                                     std::min(tileH, input.rows)));
+            if (tx + tileW >= input.cols) {
+                break;
+            }
+        }
+        if (ty + tileH >= input.rows) {
+            break;
+        }
+    }
 
-                int width = int(w / scale);
-                int height = int(h / scale);
+    size_t numTiles = tiles.size();
+    while (scratch.batchCanvases.size() < numTiles) {
+        scratch.batchCanvases.push_back(
+            cv::Mat::zeros(modelShape.height, modelShape.width, CV_8UC3));
+    }
 
-                boxes.push_back(cv::Rect(left, top, width, height));
+    // Letterbox all tiles in parallel; each worker writes its own canvas
+    // slot, so no state is shared between iterations.
+    auto stageStart = std::chrono::steady_clock::now();
+    std::vector<int> pad_xs(numTiles, 0);
+    std::vector<int> pad_ys(numTiles, 0);
+    std::vector<float> scales(numTiles, 1.0f);
+    cv::parallel_for_(cv::Range(0, (int)numTiles), [&](const cv::Range &range) {
+        for (int i = range.start; i < range.end; ++i) {
+            formatToSquare(input(tiles[i]), scratch.batchCanvases[i], &pad_xs[i],
+                           &pad_ys[i], &scales[i]);
+        }
+    });
+    auto preprocessDone = std::chrono::steady_clock::now();
+
+    // Forward in chunks of maxTileBatch tiles, collecting the per-tile NMS
+    // survivors (offset back into input coordinates) for the global merge
+    std::vector<cv::Rect> allBoxes;
+    std::vector<float> allConfidences;
+    std::vector<int> allClassIds;
+    double forwardMs = 0.0;
+
+    for (size_t first = 0; first < numTiles; first += maxTileBatch) {
+        size_t count = std::min((size_t)maxTileBatch, numTiles - first);
+        std::vector<cv::Mat> modelInputs(
+            scratch.batchCanvases.begin() + first,
+            scratch.batchCanvases.begin() + first + count);
+
+        cv::dnn::blobFromImages(modelInputs, scratch.blob, 1.0 / 255.0,
+                                modelShape, cv::Scalar(), true, false);
+
+        auto forwardStart = std::chrono::steady_clock::now();
+        std::vector<cv::Mat> outputs = backend->forward(scratch.blob);
+        forwardMs += std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - forwardStart)
+                         .count();
+
+        int d1 = outputs[0].size[1];
+        int d2 = outputs[0].size[2];
+        size_t stride = (size_t)d1 * (size_t)d2;
+        float *base = (float *)outputs[0].data;
+
+        for (size_t i = 0; i < count; ++i) {
+            size_t t = first + i;
+            cv::Mat slice(d1, d2, CV_32FC1, base + i * stride);
+            decodeCandidates(slice, pad_xs[t], pad_ys[t], scales[t]);
+            for (int idx : scratch.nms_result) {
+                cv::Rect box = scratch.boxes[idx];
+                box.x += tiles[t].x;
+                box.y += tiles[t].y;
+                allBoxes.push_back(box);
+                allConfidences.push_back(scratch.confidences[idx]);
+                allClassIds.push_back(scratch.class_ids[idx]);
             }
         }
-        else // yolov5
-        {
-            float confidence = data[4];
+    }
 
-            if (confidence >= modelConfidenceThreshold) {
-                float *classes_scores = data + 5;
+    // Global NMS: a head in an overlap region survives per-tile NMS in
+    // several tiles, so the duplicates are suppressed here
+    std::vector<int> keep;
+    cv::dnn::NMSBoxes(allBoxes, allConfidences, modelScoreThreshold,
+                      modelNMSThreshold, keep);
 
-                cv::Mat scores(1, classes.size(), CV_32FC1, classes_scores);
-                cv::Point class_id;
-                double max_class_score;
+    std::vector<Detection> detections;
+    detections.reserve(keep.size());
+    for (int idx : keep) {
+        Detection result;
+        result.class_id = allClassIds[idx];
+        result.confidence = allConfidences[idx];
+        result.box = allBoxes[idx];
+        if (debugAnnotations) {
+            std::uniform_int_distribution<int> dis(100, 255);
+            result.color = cv::Scalar(dis(rng), dis(rng), dis(rng));
+            result.className = classes[result.class_id];
+        }
+        detections.push_back(result);
+    }
 
-                minMaxLoc(scores, 0, &max_class_score, 0, &class_id);
+    auto end = std::chrono::steady_clock::now();
+    timings.preprocessMs =
+        std::chrono::duration<double, std::milli>(preprocessDone - stageStart)
+            .count();
+    timings.forwardMs = forwardMs;
+    timings.postprocessMs = std::chrono::duration<double, std::milli>(
+                                end - preprocessDone)
+                                .count()
+                            - forwardMs;
 
-                if (max_class_score > modelScoreThreshold) {
-                    confidences.push_back(confidence);
-                    class_ids.push_back(class_id.x);
+    return detections;
+}
 
-                    float x = data[0];
-                    float y = data[1];
-                    float w = data[2];
-                    float h = data[3];
+// Run the threshold scan and NMS for one output tensor, leaving the
+// surviving candidates in the scratch buffers (boxes/confidences/class_ids
+// indexed through nms_result).
+void Inference::decodeCandidates(const cv::Mat &output, int pad_x, int pad_y,
+                                 float scale)
+{
+    auto stageStart = std::chrono::steady_clock::now();
 
-                    int left = int((x - 0.5 * w - pad_x) / scale);
-                    int top = int((y - 0.5 * h - pad_y) / scale);
+    int rows = output.rows;
+    int dimensions = output.cols;
 
-                    int width = int(w / scale);
-                    int height = int(h / scale);
+    // yolov5 has an output of shape (batchSize, 25200, 85) (Num classes +
+    // box[x,y,w,h] + confidence[c]) yolov8 has an output of shape (batchSize,
+    // 84,  8400) (Num classes + box[x,y,w,h])
+    bool yolov8 = dimensions > rows;
+
+    // Reuse the preallocated candidate vectors (clear keeps capacity)
+    std::vector<int> &class_ids = scratch.class_ids;
+    std::vector<float> &confidences = scratch.confidences;
+    std::vector<cv::Rect> &boxes = scratch.boxes;
+    class_ids.clear();
+    confidences.clear();
+    boxes.clear();
+
+    if (yolov8 && classes.size() == 1) {
+        // Single-class yolov8 fast path. In the raw (5, anchors) layout the
+        // score plane is one contiguous row, so we skip the transpose and do
+        // a flat vectorized threshold scan, then gather the few surviving
+        // boxes from the coordinate rows.
+        int anchors = output.cols;
+        const float *xs = output.ptr<float>(0);
+        const float *ys = output.ptr<float>(1);
+        const float *ws = output.ptr<float>(2);
+        const float *hs = output.ptr<float>(3);
+        const float *ss = output.ptr<float>(4);
+
+        std::vector<int> &candidates = scratch.candidates;
+        candidates.clear();
+        scanScoresAboveThreshold(ss, anchors, modelScoreThreshold, candidates);
+
+        for (int idx : candidates) {
+            confidences.push_back(ss[idx]);
+            class_ids.push_back(0);
+
+            float x = xs[idx];
+            float y = ys[idx];
+            float w = ws[idx];
+            float h = hs[idx];
+
+            int left = int((x - 0.5 * w - pad_x) / scale);
+            int top = int((y - 0.5 * h - pad_y) / scale);
+
+            int width = int(w / scale);
+            int height = int(h / scale);
+
+            boxes.push_back(cv::Rect(left, top, width, height));
+        }
+    }
+    else {
+        cv::Mat decoded = output;
+        if (yolov8) {
+            rows = output.cols;
+            dimensions = output.rows;
+
+            cv::transpose(output, decoded);
+        }
+
+        // The layout and class count are fixed per model; bind the
+        // specialized decode loop on the first frame and reuse it after
+        if (!decodeRowsFn) {
+            decodeRowsFn = selectDecodeRows(yolov8, (int)classes.size());
+        }
+        decodeRowsFn((const float *)decoded.data, rows, dimensions,
+                     modelScoreThreshold, modelConfidenceThreshold, pad_x, pad_y,
+                     scale, class_ids, confidences, boxes, (int)classes.size());
+    }
+
+    std::vector<int> &nms_result = scratch.nms_result;
+    nms_result.clear();
+    if (classes.size() == 1) {
+        // Single-class model: the purpose-built NMS avoids the generic
+        // cv::dnn::NMSBoxes machinery on the hottest path
+        singleClassNMS(nms_result);
+    }
+    else {
+        cv::dnn::NMSBoxes(boxes, confidences, modelScoreThreshold,
+                          modelNMSThreshold, nms_result);
+        if ((int)nms_result.size() > modelMaxDetections) {
+            nms_result.resize(modelMaxDetections);
+        }
+    }
+
+    // Density signal for the adaptive-shape promotion
+    lastDetectionCount = (int)nms_result.size();
+
+    timings.postprocessMs = std::chrono::duration<double, std::milli>(
+                                std::chrono::steady_clock::now() - stageStart)
+                                .count();
+}
+
+// Purpose-built NMS for the single-class case. Candidates are ranked with a
+// partial sort bounded by the max-detections cap, the kept boxes live in
+// flat SoA corner/area arrays, and each candidate's IoU against the
+// survivor list is computed four boxes at a time with universal intrinsics.
+// Because candidates are visited in descending confidence order, the loop
+// stops as soon as scores drop below the threshold or the cap is reached.
+void Inference::singleClassNMS(std::vector<int> &keep)
+{
+    const std::vector<cv::Rect> &boxes = scratch.boxes;
+    const std::vector<float> &confidences = scratch.confidences;
+    int n = (int)boxes.size();
+    if (n == 0) {
+        return;
+    }
 
-                    boxes.push_back(cv::Rect(left, top, width, height));
+    std::vector<int> &order = scratch.order;
+    order.resize(n);
+    for (int i = 0; i < n; ++i) {
+        order[i] = i;
+    }
+
+    // Deliberate approximation: only the 4x-cap highest-confidence prefix is
+    // ranked and considered, which bounds the sort and the IoU loop on dense
+    // crowd frames. Exact NMS could still keep a box from beyond the prefix
+    // (one kept box may suppress arbitrarily many candidates), but below the
+    // cap those are low-confidence boxes in near-saturated scenes, where the
+    // count is dominated by the cap anyway
+    int topK = std::min(n, modelMaxDetections * 4);
+    std::partial_sort(order.begin(), order.begin() + topK, order.end(),
+                      [&](int a, int b) {
+                          return confidences[a] > confidences[b];
+                      });
+
+    std::vector<float> &kx1 = scratch.keptX1;
+    std::vector<float> &ky1 = scratch.keptY1;
+    std::vector<float> &kx2 = scratch.keptX2;
+    std::vector<float> &ky2 = scratch.keptY2;
+    std::vector<float> &karea = scratch.keptArea;
+    kx1.clear();
+    ky1.clear();
+    kx2.clear();
+    ky2.clear();
+    karea.clear();
+
+    for (int oi = 0; oi < topK; ++oi) {
+        int idx = order[oi];
+        if (confidences[idx] < modelScoreThreshold) {
+            break; // descending order: nothing below can survive
+        }
+
+        const cv::Rect &b = boxes[idx];
+        float x1 = (float)b.x;
+        float y1 = (float)b.y;
+        float x2 = (float)(b.x + b.width);
+        float y2 = (float)(b.y + b.height);
+        float area = (float)b.width * (float)b.height;
+
+        bool suppressed = false;
+        int m = (int)kx1.size();
+        int j = 0;
+#if CV_SIMD128
+        {
+            cv::v_float32x4 vx1 = cv::v_setall_f32(x1);
+            cv::v_float32x4 vy1 = cv::v_setall_f32(y1);
+            cv::v_float32x4 vx2 = cv::v_setall_f32(x2);
+            cv::v_float32x4 vy2 = cv::v_setall_f32(y2);
+            cv::v_float32x4 varea = cv::v_setall_f32(area);
+            cv::v_float32x4 vthr = cv::v_setall_f32(modelNMSThreshold);
+            cv::v_float32x4 vzero = cv::v_setzero_f32();
+            for (; j + 4 <= m; j += 4) {
+                cv::v_float32x4 iw =
+                    cv::v_max(vzero, cv::v_min(vx2, cv::v_load(kx2.data() + j))
+                                         - cv::v_max(vx1,
+                                                     cv::v_load(kx1.data() + j)));
+                cv::v_float32x4 ih =
+                    cv::v_max(vzero, cv::v_min(vy2, cv::v_load(ky2.data() + j))
+                                         - cv::v_max(vy1,
+                                                     cv::v_load(ky1.data() + j)));
+                cv::v_float32x4 inter = iw * ih;
+                // IoU > thr  <=>  inter > thr * (areaA + areaB - inter)
+                cv::v_float32x4 unionArea =
+                    varea + cv::v_load(karea.data() + j) - inter;
+                if (cv::v_check_any(inter > vthr * unionArea)) {
+                    suppressed = true;
+                    break;
                 }
             }
         }
+#endif
+        for (; !suppressed && j < m; ++j) {
+            float iw = std::min(x2, kx2[j]) - std::max(x1, kx1[j]);
+            float ih = std::min(y2, ky2[j]) - std::max(y1, ky1[j]);
+            if (iw <= 0 || ih <= 0) {
+                continue;
+            }
+            float inter = iw * ih;
+            if (inter > modelNMSThreshold * (area + karea[j] - inter)) {
+                suppressed = true;
+            }
+        }
+        if (suppressed) {
+            continue;
+        }
 
-        data += dimensions;
+        kx1.push_back(x1);
+        ky1.push_back(y1);
+        kx2.push_back(x2);
+        ky2.push_back(y2);
+        karea.push_back(area);
+        keep.push_back(idx);
+        if ((int)keep.size() >= modelMaxDetections) {
+            break;
+        }
     }
+}
 
-    std::vector<int> nms_result;
-    cv::dnn::NMSBoxes(boxes, confidences, modelScoreThreshold, modelNMSThreshold,
-                      nms_result);
+std::vector<Detection> Inference::decodeOutput(const cv::Mat &output, int pad_x,
+                                               int pad_y, float scale)
+{
+    decodeCandidates(output, pad_x, pad_y, scale);
 
     std::vector<Detection> detections{};
-    for (unsigned long i = 0; i < nms_result.size(); ++i) {
-        int idx = nms_result[i];
+    detections.reserve(scratch.nms_result.size());
+    for (unsigned long i = 0; i < scratch.nms_result.size(); ++i) {
+        int idx = scratch.nms_result[i];
 
         Detection result;
-        result.class_id = class_ids[idx];
-        result.confidence = confidences[idx];
-
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        std::uniform_int_distribution<int> dis(100, 255);
-        result.color = cv::Scalar(dis(gen), dis(gen), dis(gen));
-
-        result.className = classes[result.class_id];
-        result.box = boxes[idx];
+        result.class_id = scratch.class_ids[idx];
+        result.confidence = scratch.confidences[idx];
+        result.box = scratch.boxes[idx];
+
+        // Drawing colors and class names are debug-only; generating them per
+        // box costs a string and RNG draw each
+        if (debugAnnotations) {
+            std::uniform_int_distribution<int> dis(100, 255);
+            result.color = cv::Scalar(dis(rng), dis(rng), dis(rng));
+            result.className = classes[result.class_id];
+        }
 
         detections.push_back(result);
     }
@@ -158,23 +832,8 @@ void Inference::loadClassesFromFile()
     }
 }
 
-void Inference::loadOnnxNetwork()
-{
-    net = cv::dnn::readNetFromONNX(modelPath);
-    if (cudaEnabled) {
-        spdlog::info("Running on CUDA");
-        net.setPreferableBackend(cv::dnn::DNN_BACKEND_CUDA);
-        net.setPreferableTarget(cv::dnn::DNN_TARGET_CUDA);
-    }
-    else {
-        spdlog::info("nRunning on CPU");
-        net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
-        net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
-    }
-}
-
-cv::Mat Inference::formatToSquare(const cv::Mat &source, int *pad_x, int *pad_y,
-                                  float *scale)
+void Inference::formatToSquare(const cv::Mat &source, cv::Mat &canvas,
+                               int *pad_x, int *pad_y, float *scale)
 {
     int col = source.cols;
     int row = source.rows;
@@ -187,10 +846,22 @@ cv::Mat Inference::formatToSquare(const cv::Mat &source, int *pad_x, int *pad_y,
     *pad_x = (m_inputWidth - resized_w) / 2;
     *pad_y = (m_inputHeight - resized_h) / 2;
 
-    cv::Mat resized;
-    cv::resize(source, resized, cv::Size(resized_w, resized_h));
-    cv::Mat result = cv::Mat::zeros(m_inputHeight, m_inputWidth, source.type());
-    resized.copyTo(result(cv::Rect(*pad_x, *pad_y, resized_w, resized_h)));
-    resized.release();
-    return result;
+    // The canvas is preallocated and reused across frames; resize straight
+    // into its centered ROI and zero only the padding strips so pixels from
+    // the previous frame cannot leak in.
+    canvas.create(m_inputHeight, m_inputWidth, source.type());
+    if (*pad_y > 0) {
+        canvas(cv::Rect(0, 0, m_inputWidth, *pad_y)).setTo(cv::Scalar());
+        canvas(cv::Rect(0, *pad_y + resized_h, m_inputWidth,
+                        m_inputHeight - *pad_y - resized_h))
+            .setTo(cv::Scalar());
+    }
+    if (*pad_x > 0) {
+        canvas(cv::Rect(0, 0, *pad_x, m_inputHeight)).setTo(cv::Scalar());
+        canvas(cv::Rect(*pad_x + resized_w, 0, m_inputWidth - *pad_x - resized_w,
+                        m_inputHeight))
+            .setTo(cv::Scalar());
+    }
+    cv::Mat target = canvas(cv::Rect(*pad_x, *pad_y, resized_w, resized_h));
+    cv::resize(source, target, cv::Size(resized_w, resized_h));
 }
@@ -7,13 +7,19 @@
 #include <fstream>
 #include <vector>
 #include <string>
+#include <mutex>
 #include <random>
+#include <thread>
 
 // OpenCV / DNN / Inference
 #include <opencv2/imgproc.hpp>
 #include <opencv2/opencv.hpp>
 #include <opencv2/dnn.hpp>
 
+#include "backend.h"
+#include "gpu_preprocessor.h"
+#include "pipeline_stats.h"
+
 struct Detection {
     int class_id{0};
     std::string className{};
@@ -22,42 +28,179 @@ struct Detection {
     cv::Rect box{};
 };
 
+// Per-instance scratch buffers reused across frames so the hot path does not
+// allocate: letterbox canvases, the input blob, and the candidate vectors are
+// created once and recycled on every call.
+struct InferenceScratch {
+    cv::Mat canvas;                    // letterbox canvas, modelShape sized
+    std::vector<cv::Mat> batchCanvases; // one canvas per batch slot
+    cv::Mat blob;                      // network input blob
+    std::vector<int> class_ids;
+    std::vector<float> confidences;
+    std::vector<cv::Rect> boxes;
+    std::vector<int> nms_result;
+    std::vector<int> candidates; // indices above threshold (single-class scan)
+
+    // Single-class NMS working set: candidate order and the SoA corner/area
+    // arrays of the kept boxes (contiguous floats for the vectorized IoU)
+    std::vector<int> order;
+    std::vector<float> keptX1;
+    std::vector<float> keptY1;
+    std::vector<float> keptX2;
+    std::vector<float> keptY2;
+    std::vector<float> keptArea;
+};
+
 class Inference {
    public:
+    // Signature of the layout/class-count specialized decode loop; the
+    // matching instantiation is selected once when the output layout of the
+    // loaded model becomes known.
+    using DecodeRowsFn = void (*)(const float *data, int rows, int dimensions,
+                                  float scoreThreshold,
+                                  float confidenceThreshold, int pad_x,
+                                  int pad_y, float scale,
+                                  std::vector<int> &class_ids,
+                                  std::vector<float> &confidences,
+                                  std::vector<cv::Rect> &boxes,
+                                  int runtimeClasses);
+
     Inference(const std::string &onnxModelPath,
               const cv::Size &modelInputShape = {640, 640},
               const std::string &classesTxtFile = "",
-              const bool &runWithCuda = true);
+              const bool &runWithCuda = true,
+              const InferenceBackend backendKind = InferenceBackend::OpenCV,
+              const InferencePrecision precision = InferencePrecision::FP32,
+              const std::string &calibrationDir = "", const int deviceId = 0);
+    ~Inference();
+
+    // Run dummy frames through the network so lazy kernel/backend
+    // initialization is paid up front instead of on the first request.
+    void warmup(int iterations = 1);
+    // Same, but on a background thread so construction returns immediately.
+    // Call waitForWarmup() (or rely on the destructor) before serving.
+    void warmupAsync(int iterations = 1);
+    void waitForWarmup();
     std::vector<Detection> runInference(const cv::Mat &input);
+    std::vector<Detection> runInference(const cv::Mat &input,
+                                        const cv::Rect &roi);
+    std::vector<std::vector<Detection>> runInferenceBatch(
+        const std::vector<cv::Mat> &inputs);
+    // Adaptive input resolution. Builds one network per listed (square) input
+    // side at call time — OpenCV DNN re-imports the model per shape, so the
+    // cost is paid once here instead of on the hot path — and picks the
+    // smallest shape that covers the request's ROI per frame. A small doorway
+    // polygon then runs through the 320 net instead of being upscaled into
+    // the 640 one. densityPromoteAt is an optional feedback signal: when the
+    // previous frame on this instance produced at least that many detections,
+    // the next larger shape is used so busy scenes keep full resolution
+    // (0 disables the promotion). Batch and tiled calls always use the
+    // default shape.
+    void setAdaptiveShapes(bool enabled,
+                           const std::vector<int> &sides = {320, 480, 640},
+                           int densityPromoteAt = 8);
+
+    // Tiled inference for wide-area frames whose heads would shrink below
+    // detectability under a single letterbox. The input is covered with
+    // overlapping model-sized tiles at native resolution, the tiles run as
+    // batched forward passes, and the per-tile boxes are offset back and
+    // merged with a global NMS. Coordinates are relative to the given input
+    // (or roi), matching runInference.
+    std::vector<Detection> runInferenceTiled(const cv::Mat &input,
+                                             float overlap = 0.2f);
+    std::vector<Detection> runInferenceTiled(const cv::Mat &input,
+                                             const cv::Rect &roi,
+                                             float overlap = 0.2f);
 
+    // Debug colors and class names for drawing cost allocations per box;
+    // they are only generated when explicitly enabled.
+    void setDebugAnnotations(bool enabled) {
+        debugAnnotations = enabled;
+    }
+
+    // Stage timings of the most recent call on this instance (preprocess,
+    // forward and postprocess; decode happens in the caller).
+    const PipelineStats &lastTimings() const {
+        return timings;
+    }
+
+    // maxDetections bounds the NMS output (and its worst-case latency on
+    // dense crowd frames); surviving boxes are kept in confidence order.
     void setThresholds(float confidenceThreshold = 0.25,
-                       float scoreThreshold = 0.45, float nmsThreshold = 0.50) {
+                       float scoreThreshold = 0.45, float nmsThreshold = 0.50,
+                       int maxDetections = 300) {
         modelConfidenceThreshold = confidenceThreshold;
         modelScoreThreshold = scoreThreshold;
         modelNMSThreshold = nmsThreshold;
+        modelMaxDetections = maxDetections;
     }
 
    private:
+    // One network per supported input side; a null net means "the default
+    // backend" so the model loaded in the constructor is not duplicated.
+    struct ShapeVariant {
+        int side;
+        std::unique_ptr<IBackend> net;
+    };
+
     void loadClassesFromFile();
-    void loadOnnxNetwork();
-    cv::Mat formatToSquare(const cv::Mat &source, int *pad_x, int *pad_y,
-                           float *scale);
+    void selectShapeFor(const cv::Mat &input);
+    void resetDefaultShape();
+    void formatToSquare(const cv::Mat &source, cv::Mat &canvas, int *pad_x,
+                        int *pad_y, float *scale);
+    cv::Mat forwardFrame(const cv::Mat &input, int *pad_x, int *pad_y,
+                         float *scale);
+    void decodeCandidates(const cv::Mat &output, int pad_x, int pad_y,
+                          float scale);
+    void singleClassNMS(std::vector<int> &keep);
+    std::vector<Detection> decodeOutput(const cv::Mat &output, int pad_x,
+                                        int pad_y, float scale);
+
+    // Expected number of output rows for a 640x640 yolov8 head; used to size
+    // the candidate vectors up front.
+    static constexpr int expectedRows = 8400;
+
+    // Upper bound on tiles per forward pass in tiled mode, to keep the input
+    // blob memory bounded on large 4K grids.
+    static constexpr int maxTileBatch = 8;
 
     std::string modelPath{};
     std::string classesPath{};
     bool cudaEnabled{};
+    // Construction parameters kept so setAdaptiveShapes can build the
+    // per-shape networks with the same backend configuration.
+    InferenceBackend backendKindUsed{InferenceBackend::OpenCV};
+    InferencePrecision precisionUsed{InferencePrecision::FP32};
+    std::string calibrationDirUsed{};
+    int deviceIdUsed{0};
 
     std::vector<std::string> classes{"head"};
 
     cv::Size2f modelShape{};
+    cv::Size2f defaultShape{}; // shape given at construction
 
     float modelConfidenceThreshold{0.25};
     float modelScoreThreshold{0.45};
     float modelNMSThreshold{0.50};
+    int modelMaxDetections{300};
 
     bool letterBoxForSquare = true;
+    bool debugAnnotations = false;
+    PipelineStats timings;
+    std::mt19937 rng{std::random_device{}()};
 
-    cv::dnn::Net net;
+    std::unique_ptr<IBackend> backend;
+    IBackend *activeBackend = nullptr;   // backend for the selected shape
+    std::vector<ShapeVariant> shapeVariants; // ascending by side; empty = off
+    int densityPromoteAt = 0;  // detections that promote to the next shape
+    int lastDetectionCount = 0; // NMS survivors of the most recent frame
+    InferenceScratch scratch;
+    DecodeRowsFn decodeRowsFn = nullptr; // bound on the first decoded frame
+    std::thread warmupThread; // guarded by warmupMtx
+    std::mutex warmupMtx;
+#ifdef WITH_CUDA_PREPROC
+    std::unique_ptr<GpuPreprocessor> gpuPreproc;
+#endif
 };
 
 #endif  // INFERENCE_H
@@ -0,0 +1,162 @@
+/*
+ * This file is part of [Head Count Web Application].
+ *
+ * Copyright (C) 2025 TakumiVision co., ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "jpeg_decoder.h"
+
+#include <algorithm>
+
+#include <spdlog/spdlog.h>
+
+#ifdef WITH_LIBJPEG_TURBO
+#include <csetjmp>
+#include <cstdio>
+#include <jpeglib.h>
+
+// libjpegのエラーをlongjmpで回収するためのエラーマネージャ
+struct JpegErrorMgr
+{
+    jpeg_error_mgr pub;
+    jmp_buf setjmpBuffer;
+};
+
+static void jpegErrorExit(j_common_ptr cinfo)
+{
+    JpegErrorMgr *err = (JpegErrorMgr *)cinfo->err;
+    longjmp(err->setjmpBuffer, 1);
+}
+
+// libjpeg-turboによる縮小・部分デコード
+// ROIと交差するスキャンライン帯のみを読み、前後はjpeg_skip_scanlinesで
+// スキップする。水平方向はjpeg_crop_scanlineによりMCU境界へ丸められる。
+static bool decodeWithLibjpeg(const unsigned char *data, size_t size,
+                              const cv::Rect &roiHint, int denom,
+                              DecodedFrame &frame)
+{
+    jpeg_decompress_struct cinfo;
+    JpegErrorMgr jerr;
+    cinfo.err = jpeg_std_error(&jerr.pub);
+    jerr.pub.error_exit = jpegErrorExit;
+    if (setjmp(jerr.setjmpBuffer)) {
+        jpeg_destroy_decompress(&cinfo);
+        return false;
+    }
+
+    jpeg_create_decompress(&cinfo);
+    jpeg_mem_src(&cinfo, data, (unsigned long)size);
+    jpeg_read_header(&cinfo, TRUE);
+
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = (unsigned int)denom;
+    cinfo.out_color_space = JCS_EXT_BGR;
+    jpeg_start_decompress(&cinfo);
+
+    int outW = (int)cinfo.output_width;
+    int outH = (int)cinfo.output_height;
+
+    // 出力座標系（スケール適用後）でのデコード帯を決定
+    int roiTop = 0;
+    int roiBottom = outH;
+    int roiLeft = 0;
+    int roiWidth = outW;
+    if (roiHint.width > 0 && roiHint.height > 0) {
+        roiTop = std::max(0, roiHint.y / denom);
+        roiBottom =
+            std::min(outH, (roiHint.y + roiHint.height + denom - 1) / denom);
+        roiLeft = std::max(0, roiHint.x / denom);
+        roiWidth = std::min(outW, (roiHint.x + roiHint.width + denom - 1) / denom)
+                   - roiLeft;
+        if (roiBottom <= roiTop || roiWidth <= 0) {
+            roiTop = 0;
+            roiBottom = outH;
+            roiLeft = 0;
+            roiWidth = outW;
+        }
+    }
+
+    JDIMENSION cropX = (JDIMENSION)roiLeft;
+    JDIMENSION cropW = (JDIMENSION)roiWidth;
+    if (roiLeft > 0 || roiWidth < outW) {
+        jpeg_crop_scanline(&cinfo, &cropX, &cropW);
+    }
+
+    cv::Mat image(roiBottom - roiTop, (int)cropW, CV_8UC3);
+
+    if (roiTop > 0) {
+        jpeg_skip_scanlines(&cinfo, (JDIMENSION)roiTop);
+    }
+    while ((int)cinfo.output_scanline < roiBottom) {
+        JSAMPROW row = image.ptr<JSAMPLE>((int)cinfo.output_scanline - roiTop);
+        jpeg_read_scanlines(&cinfo, &row, 1);
+    }
+    if ((int)cinfo.output_scanline < outH) {
+        jpeg_skip_scanlines(&cinfo,
+                            (JDIMENSION)(outH - (int)cinfo.output_scanline));
+    }
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+
+    frame.image = image;
+    frame.scaleDenom = denom;
+    frame.offsetX = (int)cropX * denom;
+    frame.offsetY = roiTop * denom;
+    return true;
+}
+#endif // WITH_LIBJPEG_TURBO
+
+DecodedFrame JpegDecoder::decode(const unsigned char *data, size_t size,
+                                 const cv::Rect &roiHint,
+                                 const cv::Size &modelSize)
+{
+    DecodedFrame frame;
+
+    // 縮小してもROIがモデル入力サイズを下回らない最大の縮小率を選ぶ
+    int denom = 1;
+    if (roiHint.width > 0 && roiHint.height > 0 && modelSize.width > 0
+        && modelSize.height > 0) {
+        while (denom < 8 && roiHint.width / (denom * 2) >= modelSize.width
+               && roiHint.height / (denom * 2) >= modelSize.height) {
+            denom *= 2;
+        }
+    }
+
+#ifdef WITH_LIBJPEG_TURBO
+    if (decodeWithLibjpeg(data, size, roiHint, denom, frame)) {
+        return frame;
+    }
+    spdlog::warn("libjpeg decode failed, falling back to cv::imdecode");
+#endif
+
+    // OpenCVフォールバック（縮小デコードのみ、部分デコードなし）
+    cv::Mat encoded(1, (int)size, CV_8UC1, const_cast<unsigned char *>(data));
+    int flag = cv::IMREAD_COLOR;
+    if (denom == 2) {
+        flag = cv::IMREAD_REDUCED_COLOR_2;
+    }
+    else if (denom == 4) {
+        flag = cv::IMREAD_REDUCED_COLOR_4;
+    }
+    else if (denom == 8) {
+        flag = cv::IMREAD_REDUCED_COLOR_8;
+    }
+    frame.image = cv::imdecode(encoded, flag);
+    frame.scaleDenom = frame.image.empty() ? 1 : denom;
+    frame.offsetX = 0;
+    frame.offsetY = 0;
+    return frame;
+}
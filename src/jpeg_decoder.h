@@ -0,0 +1,54 @@
+/*
+ * This file is part of [Head Count Web Application].
+ *
+ * Copyright (C) 2025 TakumiVision co., ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __JPEG_DECODER_H__
+#define __JPEG_DECODER_H__
+#include <cstddef>
+
+#include <opencv2/opencv.hpp>
+
+// デコード結果構造体
+// 縮小デコード・部分デコードを行った場合、画像座標を元画像座標へ戻すための
+// スケールとオフセットを保持する
+struct DecodedFrame
+{
+    cv::Mat image;  // デコード画像（BGR）
+    int scaleDenom; // 縮小率の分母（1, 2, 4, 8）
+    int offsetX;    // 元画像座標に対するデコード領域の水平オフセット
+    int offsetY;    // 元画像座標に対するデコード領域の垂直オフセット
+
+    DecodedFrame() : scaleDenom(1), offsetX(0), offsetY(0)
+    {
+    }
+};
+
+// JPEGデコードサブシステム
+// ROIとモデル入力サイズの比率が許す場合は縮小デコード（1/2, 1/4, 1/8）を行い、
+// libjpeg-turboが利用可能な場合はROIと交差するスキャンライン帯のみをデコード
+// する。それ以外はcv::imdecodeにフォールバックする。
+class JpegDecoder
+{
+  public:
+    // JPEGデータをデコードする
+    // roiHint:   検出対象領域（元画像座標）。無効な場合は全体をデコード
+    // modelSize: モデル入力サイズ（縮小率の下限決定に使用）
+    DecodedFrame decode(const unsigned char *data, size_t size,
+                        const cv::Rect &roiHint, const cv::Size &modelSize);
+};
+#endif
@@ -0,0 +1,57 @@
+/*
+ * This file is part of [Head Count Web Application].
+ *
+ * Copyright (C) 2025 TakumiVision co., ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "logging.h"
+
+#include <mutex>
+
+#include <spdlog/async.h>
+#include <spdlog/sinks/rotating_file_sink.h>
+
+namespace {
+std::once_flag loggingOnce;
+bool loggerInjected = false;
+} // namespace
+
+void initLogging(const std::string &logPath, spdlog::level::level_enum level)
+{
+    std::call_once(loggingOnce, [&] {
+        if (loggerInjected) {
+            return;
+        }
+        // 有界キュー8192件・ワーカースレッド1本。キューが一杯の場合は
+        // 古いメッセージを破棄し、呼び出し側をブロックしない
+        spdlog::init_thread_pool(8192, 1);
+        auto sink = std::make_shared<spdlog::sinks::rotating_file_sink_mt>(
+            logPath, 1048576, 5);
+        auto logger = std::make_shared<spdlog::async_logger>(
+            "headcount_logger", sink, spdlog::thread_pool(),
+            spdlog::async_overflow_policy::overrun_oldest);
+        spdlog::set_default_logger(logger);
+        spdlog::set_level(level);
+        spdlog::flush_on(spdlog::level::err);
+    });
+}
+
+void setLogger(std::shared_ptr<spdlog::logger> logger)
+{
+    std::call_once(loggingOnce, [] {});
+    loggerInjected = true;
+    spdlog::set_default_logger(std::move(logger));
+}
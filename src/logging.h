@@ -0,0 +1,36 @@
+/*
+ * This file is part of [Head Count Web Application].
+ *
+ * Copyright (C) 2025 TakumiVision co., ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LOGGING_H__
+#define __LOGGING_H__
+#include <memory>
+#include <string>
+
+#include <spdlog/spdlog.h>
+
+// 非同期ロガーをプロセスで一度だけ初期化する（2回目以降の呼び出しは無視）
+// ログ書き込みは有界キュー経由のバックグラウンドスレッドで行われ、キューが
+// 溢れた場合は古いメッセージを破棄する（リクエストパスをブロックしない）
+void initLogging(const std::string &logPath = "log.txt",
+                 spdlog::level::level_enum level = spdlog::level::info);
+
+// 外部で構築したロガーを注入する（テスト・組み込み用）。
+// initLoggingより先に呼ぶこと
+void setLogger(std::shared_ptr<spdlog::logger> logger);
+#endif
@@ -18,15 +18,163 @@
  */
 
 #include "person_counter.h"
+#include "person_counter_pool.h"
+#include "pipeline_stats.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <fstream>
 #include <vector>
 #include <iostream>
 #include <string>
 #include <memory>
+#include <thread>
 
 #include <opencv2/opencv.hpp>
 
+// ソート済み遅延リストからパーセンタイル値を取り出す
+static double percentile(const std::vector<double> &sorted, double p)
+{
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t idx = (size_t)(p * (double)(sorted.size() - 1));
+    return sorted[idx];
+}
+
+// ベンチマークモード
+// ディレクトリ内のJPEGを読み込み、指定スレッド数で指定秒数だけ
+// PersonCounterPoolを最大レートで駆動し、fps・遅延パーセンタイル・
+// 段階別の平均時間をJSONで標準出力へ出す
+static int runBench(const std::string &dir, int threads, int durationSec,
+                    int batchSize)
+{
+    // ディレクトリからJPEGファイルを列挙する
+    std::vector<cv::String> files;
+    cv::glob(dir + "/*.jpg", files, false);
+    std::vector<cv::String> jpegFiles;
+    cv::glob(dir + "/*.jpeg", jpegFiles, false);
+    files.insert(files.end(), jpegFiles.begin(), jpegFiles.end());
+    if (files.empty()) {
+        std::cerr << "no JPEG files found in: " << dir << std::endl;
+        return 1;
+    }
+
+    // 全画像をメモリへ先読みし、画像サイズから全面ROIの頂点を作る
+    // （I/Oをループから外し、検出パイプラインだけを測る）
+    std::vector<std::vector<unsigned char>> images;
+    std::vector<std::vector<OBJPos>> allVertices;
+    for (auto &&path : files) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            continue;
+        }
+        file.seekg(0, std::ios::end);
+        std::streamsize size = file.tellg();
+        file.seekg(0, std::ios::beg);
+        std::vector<unsigned char> data(size);
+        if (!file.read(reinterpret_cast<char *>(data.data()), size)) {
+            continue;
+        }
+        cv::Mat img = cv::imdecode(data, cv::IMREAD_COLOR);
+        if (img.empty()) {
+            continue;
+        }
+        std::vector<OBJPos> vertices;
+        vertices.emplace_back(0, 0);
+        vertices.emplace_back(img.cols, 0);
+        vertices.emplace_back(img.cols, img.rows);
+        vertices.emplace_back(0, img.rows);
+        images.push_back(std::move(data));
+        allVertices.push_back(std::move(vertices));
+    }
+    if (images.empty()) {
+        std::cerr << "no decodable JPEG files in: " << dir << std::endl;
+        return 1;
+    }
+
+    std::cerr << "bench: " << images.size() << " images, " << threads
+              << " threads, " << durationSec << " s, batchSize=" << batchSize
+              << std::endl;
+
+    Thresholds thresholds(0.2f, 0.2f, 0.2f);
+    PersonCounterPool pool(threads, batchSize);
+
+    // ウォームアップ：遅延初期化を計測から外す
+    pool.wait(pool.submit(images[0], allVertices[0], thresholds));
+    StatsRegistry::instance().reset();
+
+    // ドライバスレッド：submit→waitを最大レートで回し、
+    // エンドツーエンド遅延をスレッドローカルに記録する
+    std::atomic<bool> stopFlag{false};
+    std::vector<std::vector<double>> latencies(threads);
+    std::vector<std::thread> drivers;
+    auto benchStart = std::chrono::steady_clock::now();
+    for (int t = 0; t < threads; ++t) {
+        drivers.emplace_back([&, t] {
+            size_t next = (size_t)t;
+            while (!stopFlag.load(std::memory_order_relaxed)) {
+                size_t i = next++ % images.size();
+                auto t0 = std::chrono::steady_clock::now();
+                pool.wait(pool.submit(images[i], allVertices[i], thresholds));
+                latencies[t].push_back(
+                    std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - t0)
+                        .count());
+            }
+        });
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(durationSec));
+    stopFlag.store(true);
+    for (auto &&driver : drivers) {
+        driver.join();
+    }
+    double elapsedSec = std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - benchStart)
+                            .count();
+
+    // 遅延を統合してパーセンタイルを計算する
+    std::vector<double> all;
+    for (auto &&local : latencies) {
+        all.insert(all.end(), local.begin(), local.end());
+    }
+    std::sort(all.begin(), all.end());
+    uint64_t frames = (uint64_t)all.size();
+
+    StatsRegistry::Snapshot stats = StatsRegistry::instance().snapshot();
+    double statFrames = stats.frames > 0 ? (double)stats.frames : 1.0;
+
+    // 結果をJSONで出力する（標準出力はJSONのみ。ログは標準エラーへ）
+    char buf[1024];
+    snprintf(buf, sizeof(buf),
+             "{\n"
+             "  \"images\": %zu,\n"
+             "  \"threads\": %d,\n"
+             "  \"batch_size\": %d,\n"
+             "  \"duration_sec\": %.2f,\n"
+             "  \"frames\": %llu,\n"
+             "  \"fps\": %.2f,\n"
+             "  \"latency_ms\": {\"p50\": %.2f, \"p95\": %.2f, \"p99\": %.2f},\n"
+             "  \"stage_ms\": {\"decode\": %.2f, \"preprocess\": %.2f, "
+             "\"forward\": %.2f, \"postprocess\": %.2f},\n"
+             "  \"detections_per_frame\": %.2f\n"
+             "}",
+             images.size(), threads, batchSize, elapsedSec,
+             (unsigned long long)frames,
+             elapsedSec > 0 ? (double)frames / elapsedSec : 0.0,
+             percentile(all, 0.50), percentile(all, 0.95),
+             percentile(all, 0.99), stats.decodeMsTotal / statFrames,
+             stats.preprocessMsTotal / statFrames,
+             stats.forwardMsTotal / statFrames,
+             stats.postprocessMsTotal / statFrames,
+             (double)stats.detectionsTotal / statFrames);
+    std::cout << buf << std::endl;
+
+    return 0;
+}
+
 int main(int argc, char *argv[])
 {
     std::string imagepath;
@@ -40,8 +188,46 @@ int main(int argc, char *argv[])
         else if (arg == "--help") {
             std::cout << "Usage: person_counter [--version | --help | imagepath]"
                       << std::endl;
+            std::cout << "       person_counter --bench <jpegDir> "
+                         "[--threads N] [--duration SEC] [--batch N]"
+                      << std::endl;
             return 0;
         }
+        else if (arg == "--bench") {
+            // ベンチマークモードのオプションを解析する
+            std::string dir;
+            int threads = 2;
+            int durationSec = 30;
+            int batchSize = 0;
+            for (int i = 2; i < argc; ++i) {
+                std::string opt = argv[i];
+                if (opt == "--threads" && i + 1 < argc) {
+                    threads = std::stoi(argv[++i]);
+                }
+                else if (opt == "--duration" && i + 1 < argc) {
+                    durationSec = std::stoi(argv[++i]);
+                }
+                else if (opt == "--batch" && i + 1 < argc) {
+                    batchSize = std::stoi(argv[++i]);
+                }
+                else {
+                    dir = opt;
+                }
+            }
+            if (dir.empty()) {
+                std::cerr << "usage: person_counter --bench <jpegDir> "
+                             "[--threads N] [--duration SEC] [--batch N]"
+                          << std::endl;
+                return 1;
+            }
+            if (threads < 1) {
+                threads = 1;
+            }
+            if (durationSec < 1) {
+                durationSec = 1;
+            }
+            return runBench(dir, threads, durationSec, batchSize);
+        }
         else {
             imagepath = arg;
             std::cout << "Image path provided: " << imagepath << std::endl;
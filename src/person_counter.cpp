@@ -19,30 +19,290 @@
 
 #include "person_counter.h"
 
+#include <chrono>
+#include <climits>
+#include <thread>
+
+#include "batch_scheduler.h"
+#include "count_aggregator.h"
+#include "device_scheduler.h"
+#include "frame_ring.h"
+#include "head_tracker.h"
+#include "logging.h"
+
 #include <spdlog/spdlog.h>
 #include <spdlog/sinks/rotating_file_sink.h>
 
 PersonCounter::PersonCounter()
 {
-    // ログの初期化
-    auto logger =
-        spdlog::rotating_logger_mt("headcount_logger", "log.txt", 1048576, 5);
-    spdlog::set_default_logger(logger);
-    spdlog::set_level(spdlog::level::info);
+    // ログの初期化（プロセスで一度だけ・非同期。2個目以降のインスタンスでは
+    // 何もしないため、複数インスタンス化しても例外にならない）
+    initLogging();
 
     // Inferenceクラスのインスタンスを作成
-    inf =
-        std::make_shared<Inference>("./model/yolov8x_head.onnx", // ONNXモデルのパス
-                                    cv::Size(640, 640),    // モデルの入力サイズ
-                                    "./model/classes.txt", // クラス名のファイルパス
-                                    true                   // CUDAを使用するかどうか
-        );
+    inf = createDefaultInference();
+}
+
+PersonCounter::PersonCounter(std::shared_ptr<Inference> inference)
+    : inf(std::move(inference))
+{
 }
 
 PersonCounter::~PersonCounter()
 {
     // ログをフラッシュ
-    spdlog::get("headcount_logger")->flush();
+    spdlog::default_logger()->flush();
+}
+
+std::shared_ptr<Inference> PersonCounter::createDefaultInference(int deviceId)
+{
+    return std::make_shared<Inference>(
+        "./model/yolov8x_head.onnx", // ONNXモデルのパス
+        cv::Size(640, 640),          // モデルの入力サイズ
+        "./model/classes.txt",       // クラス名のファイルパス
+        true,                        // CUDAを使用するかどうか
+        InferenceBackend::OpenCV, InferencePrecision::FP32, "",
+        deviceId // 推論を実行するCUDAデバイス
+    );
+}
+
+std::vector<float> PersonCounter::detectHeadsFlat(const unsigned char *jpegData,
+                                                  size_t jpegSize,
+                                                  std::vector<OBJPos> &vertices,
+                                                  Thresholds &thresholds,
+                                                  int cameraId)
+{
+    std::vector<Rect> heads =
+        detectHeads(jpegData, jpegSize, vertices, thresholds, cameraId);
+
+    std::vector<float> flat;
+    flat.reserve(heads.size() * 5);
+    for (auto &&head : heads) {
+        flat.push_back((float)head.x);
+        flat.push_back((float)head.y);
+        flat.push_back((float)head.width);
+        flat.push_back((float)head.height);
+        flat.push_back(head.confidence);
+    }
+    return flat;
+}
+
+void PersonCounter::setBatchScheduler(std::shared_ptr<BatchScheduler> scheduler)
+{
+    batchScheduler = std::move(scheduler);
+}
+
+void PersonCounter::setDeviceScheduler(std::shared_ptr<DeviceScheduler> scheduler)
+{
+    deviceScheduler = std::move(scheduler);
+}
+
+void PersonCounter::setAdaptiveShapes(bool enabled,
+                                      const std::vector<int> &sides,
+                                      int densityPromoteAt)
+{
+    inf->setAdaptiveShapes(enabled, sides, densityPromoteAt);
+}
+
+void PersonCounter::setTiledMode(bool enabled, float overlap)
+{
+    tiledEnabled = enabled;
+    tileOverlap = overlap;
+}
+
+ResultCache::ResultCache(size_t capacity_) : capacity(capacity_)
+{
+}
+
+bool ResultCache::lookup(uint64_t key, std::vector<Rect> &result)
+{
+    auto it = index.find(key);
+    if (it == index.end()) {
+        return false;
+    }
+    // ヒットしたエントリを先頭（最近使用）へ移動する
+    entries.splice(entries.begin(), entries, it->second);
+    result = entries.front().result;
+    return true;
+}
+
+void ResultCache::store(uint64_t key, const std::vector<Rect> &result)
+{
+    auto it = index.find(key);
+    if (it != index.end()) {
+        entries.splice(entries.begin(), entries, it->second);
+        entries.front().result = result;
+        return;
+    }
+
+    entries.push_front(Entry{key, result});
+    index[key] = entries.begin();
+
+    if (entries.size() > capacity) {
+        index.erase(entries.back().key);
+        entries.pop_back();
+    }
+}
+
+// 64bit FNV-1aハッシュ
+static uint64_t fnv1a64(const void *data, size_t size, uint64_t hash)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// 入力JPEG・頂点列・閾値から結果キャッシュのキーを計算する
+static uint64_t cacheKey(const unsigned char *jpegData, size_t jpegSize,
+                         const std::vector<OBJPos> &vertices,
+                         const Thresholds &thresholds)
+{
+    uint64_t hash = 14695981039346656037ull;
+    hash = fnv1a64(jpegData, jpegSize, hash);
+    if (!vertices.empty()) {
+        hash = fnv1a64(vertices.data(), vertices.size() * sizeof(OBJPos), hash);
+    }
+    hash = fnv1a64(&thresholds.confidenceThreshold, sizeof(float), hash);
+    hash = fnv1a64(&thresholds.scoreThreshold, sizeof(float), hash);
+    hash = fnv1a64(&thresholds.nmsThreshold, sizeof(float), hash);
+    hash = fnv1a64(&thresholds.maxDetections, sizeof(int), hash);
+    return hash;
+}
+
+void PersonCounter::setResultCache(bool enabled, size_t capacity)
+{
+    resultCacheEnabled = enabled;
+    resultCache = ResultCache(capacity);
+}
+
+void PersonCounter::setTracking(bool enabled, int detectEvery,
+                                float iouThreshold, int maxMissed)
+{
+    if (enabled) {
+        tracker = std::make_shared<HeadTracker>(detectEvery, iouThreshold,
+                                                maxMissed);
+    }
+    else {
+        tracker.reset();
+    }
+}
+
+void PersonCounter::setMotionGate(bool enabled, double threshold)
+{
+    motionGateEnabled = enabled;
+    motionThreshold = threshold;
+}
+
+void PersonCounter::warmup(int iterations, bool background)
+{
+    if (background) {
+        inf->warmupAsync(iterations);
+    }
+    else {
+        inf->warmup(iterations);
+    }
+}
+
+bool MotionGate::shouldRun(int cameraId, const cv::Mat &roi, double threshold)
+{
+    CameraState &state = cameras[cameraId];
+
+    // ROIを縮小グレースケールへ変換（差分計算はこの縮小画像上で行う）
+    cv::cvtColor(roi, gray, cv::COLOR_BGR2GRAY);
+    cv::resize(gray, small, cv::Size(downsampleSize, downsampleSize), 0, 0,
+               cv::INTER_AREA);
+
+    // 初回、または前回結果がない場合は必ず推論を実行する
+    if (state.reference.empty() || !state.hasResult
+        || state.reference.size() != small.size()) {
+        small.copyTo(state.reference);
+        return true;
+    }
+
+    // 画素あたりの平均絶対差分
+    double sad = cv::norm(small, state.reference, cv::NORM_L1)
+                 / (double)(downsampleSize * downsampleSize);
+    if (sad < threshold) {
+        return false;
+    }
+
+    // 動きあり：基準フレームを更新して推論へ
+    small.copyTo(state.reference);
+    return true;
+}
+
+void MotionGate::storeResult(int cameraId, const std::vector<Rect> &results)
+{
+    CameraState &state = cameras[cameraId];
+    state.lastResult = results;
+    state.hasResult = true;
+}
+
+const std::vector<Rect> &MotionGate::cachedResult(int cameraId)
+{
+    return cameras[cameraId].lastResult;
+}
+
+void PolygonFilter::build(const std::vector<OBJPos> &verts)
+{
+    vertices = verts;
+    edges.clear();
+    edges.reserve(verts.size());
+
+    size_t n = verts.size();
+    for (size_t i = 0; i < n; ++i) {
+        const OBJPos &a = verts[i];
+        const OBJPos &b = verts[(i + 1) % n];
+        if (a.y == b.y) {
+            continue; // 水平エッジは交差判定に寄与しない
+        }
+        Edge edge;
+        if (a.y < b.y) {
+            edge.y0 = (float)a.y;
+            edge.y1 = (float)b.y;
+            edge.x0 = (float)a.x;
+            edge.slope = (float)(b.x - a.x) / (float)(b.y - a.y);
+        }
+        else {
+            edge.y0 = (float)b.y;
+            edge.y1 = (float)a.y;
+            edge.x0 = (float)b.x;
+            edge.slope = (float)(a.x - b.x) / (float)(a.y - b.y);
+        }
+        edges.push_back(edge);
+    }
+}
+
+bool PolygonFilter::matches(const std::vector<OBJPos> &verts) const
+{
+    if (vertices.size() != verts.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < verts.size(); ++i) {
+        if (vertices[i].x != verts[i].x || vertices[i].y != verts[i].y) {
+            return false;
+        }
+    }
+    return !vertices.empty();
+}
+
+bool PolygonFilter::contains(float px, float py) const
+{
+    // 交差数判定（even-odd規則）：点から右方向への半直線と
+    // エッジの交差回数が奇数なら内側
+    bool inside = false;
+    for (auto &&edge : edges) {
+        if (py >= edge.y0 && py < edge.y1) {
+            float ix = edge.x0 + (py - edge.y0) * edge.slope;
+            if (px < ix) {
+                inside = !inside;
+            }
+        }
+    }
+    return inside;
 }
 
 // 多角形を内包する矩形取得
@@ -88,31 +348,283 @@ static cv::Rect getTgtRect(std::vector<OBJPos> &vertices, int cam_width,
  */
 std::vector<Rect> PersonCounter::detectHeads(std::vector<unsigned char> &jpegData,
                                              std::vector<OBJPos> &vertices,
-                                             Thresholds &thresholds)
+                                             Thresholds &thresholds, int cameraId)
 {
-    cv::Mat img = cv::imdecode(jpegData, cv::IMREAD_COLOR);
-    if (img.empty()) {
+    return detectHeads(jpegData.data(), jpegData.size(), vertices, thresholds,
+                       cameraId);
+}
+
+/**
+ * @brief JPEG画像から人物の頭部を検出します（バッファ参照版）。
+ *
+ * 呼び出し元のバッファを直接参照するため、JPEGデータのコピーは発生しません。
+ * バッファは呼び出しが完了するまで有効である必要があります。
+ *
+ * @param jpegData      JPEG 形式の画像データの先頭ポインタ
+ * @param jpegSize      JPEG データのバイト数
+ * @param vertices      検出対象領域を示す多角形頂点の座標（OBJPos型の vector）
+ * @param thresholds    検出処理に用いる各種しきい値パラメータ（構造体）
+ * @param cameraId      カメラ識別子（>= 0 で静止シーンゲートの対象になる）
+ *
+ * @return              検出された頭部領域の矩形（Rect型）の vector
+ */
+std::vector<Rect> PersonCounter::detectHeads(const unsigned char *jpegData,
+                                             size_t jpegSize,
+                                             std::vector<OBJPos> &vertices,
+                                             Thresholds &thresholds, int cameraId)
+{
+    // 結果キャッシュ有効時：バイト単位で同一の入力（JPEG・頂点列・閾値）は
+    // デコードも推論も行わず保存済みの結果を返す
+    uint64_t key = 0;
+    if (resultCacheEnabled) {
+        key = cacheKey(jpegData, jpegSize, vertices, thresholds);
+        std::vector<Rect> cached;
+        if (resultCache.lookup(key, cached)) {
+            StatsRegistry::instance().recordCacheHit();
+
+            PipelineStats sample;
+            sample.detections = (int)cached.size();
+            sample.inputBytes = jpegSize;
+            StatsRegistry::instance().record(sample);
+            CountAggregator::instance().record(cameraId, (int)cached.size());
+            return cached;
+        }
+        StatsRegistry::instance().recordCacheMiss();
+    }
+
+    // トラッキング有効時：検出フレーム以外はデコードも推論も行わず、
+    // トラッカの外挿のみで応答する
+    if (tracker && cameraId >= 0 && !tracker->needsDetection(cameraId)) {
+        std::vector<Rect> predicted = tracker->predict(cameraId);
+        PipelineStats sample;
+        sample.detections = (int)predicted.size();
+        sample.inputBytes = jpegSize;
+        StatsRegistry::instance().record(sample);
+        CountAggregator::instance().record(cameraId, (int)predicted.size());
+        return predicted;
+    }
+
+    auto decodeStart = std::chrono::steady_clock::now();
+
+    // 縮小率の選択に使うため、先に頂点列からROI（元画像座標）を求める。
+    // 頂点列が空の場合は全画面を対象とする（空のヒントで全体デコード）
+    cv::Rect fullRoi =
+        vertices.empty() ? cv::Rect() : getTgtRect(vertices, INT_MAX, INT_MAX);
+
+    // ROIがモデル入力サイズに対して十分大きい場合は縮小・部分デコードを行う
+    DecodedFrame frame =
+        decoder.decode(jpegData, jpegSize, fullRoi, cv::Size(640, 640));
+    double decodeMs = std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - decodeStart)
+                          .count();
+    if (frame.image.empty()) {
         spdlog::error("Failed to decode JPEG data.");
         return std::vector<Rect>();
     }
 
-    int width = img.cols;
-    int height = img.rows;
+    std::vector<Rect> results =
+        detectOnFrame(frame, decodeMs, jpegSize, vertices, thresholds, cameraId);
+    if (resultCacheEnabled) {
+        resultCache.store(key, results);
+    }
+    return results;
+}
+
+/**
+ * @brief デコード済みフレームから人物の頭部を検出します。
+ *
+ * RTSP取り込みなど、JPEGを経由しない経路から使用します。
+ * フレームは等倍（縮小・オフセットなし）として扱われ、結果は
+ * フレーム座標系で返されます。
+ *
+ * @param image         BGR形式のデコード済みフレーム
+ * @param vertices      検出対象領域を示す多角形頂点の座標（OBJPos型の vector）
+ * @param thresholds    検出処理に用いる各種しきい値パラメータ（構造体）
+ * @param cameraId      カメラ識別子（>= 0 で静止シーンゲートの対象になる）
+ *
+ * @return              検出された頭部領域の矩形（Rect型）の vector
+ */
+std::vector<Rect> PersonCounter::detectHeads(const cv::Mat &image,
+                                             std::vector<OBJPos> &vertices,
+                                             Thresholds &thresholds, int cameraId)
+{
+    if (image.empty()) {
+        spdlog::error("Empty frame.");
+        return std::vector<Rect>();
+    }
+
+    // トラッキング有効時：検出フレーム以外は外挿のみで応答する
+    if (tracker && cameraId >= 0 && !tracker->needsDetection(cameraId)) {
+        std::vector<Rect> predicted = tracker->predict(cameraId);
+        PipelineStats sample;
+        sample.detections = (int)predicted.size();
+        StatsRegistry::instance().record(sample);
+        CountAggregator::instance().record(cameraId, (int)predicted.size());
+        return predicted;
+    }
+
+    DecodedFrame frame;
+    frame.image = image;
+    frame.scaleDenom = 1;
+    frame.offsetX = 0;
+    frame.offsetY = 0;
+    return detectOnFrame(frame, 0.0, image.total() * image.elemSize(), vertices,
+                         thresholds, cameraId);
+}
 
-    cv::Rect tgtRect = getTgtRect(vertices, width, height);
+/**
+ * @brief 共有メモリリングのスロットから人物の頭部を検出します。
+ *
+ * スロットのペイロードを共有メモリ上で直接参照するため、フレームの
+ * コピーは発生しません。検出中にプロデューサが同じスロットへ追い付いて
+ * 上書きした場合はシーケンス番号の不一致として検出し、数回まで読み直します。
+ *
+ * @param ring          接続済みのFrameRing
+ * @param slotIndex     読み出すスロット番号（プロデューサのwrite()の戻り値）
+ * @param vertices      検出対象領域を示す多角形頂点の座標（OBJPos型の vector）
+ * @param thresholds    検出処理に用いる各種しきい値パラメータ（構造体）
+ * @param cameraId      カメラ識別子（>= 0 で静止シーンゲートの対象になる）
+ *
+ * @return              検出された頭部領域の矩形（Rect型）の vector
+ */
+std::vector<Rect> PersonCounter::detectHeadsFromRing(FrameRing &ring,
+                                                     uint64_t slotIndex,
+                                                     std::vector<OBJPos> &vertices,
+                                                     Thresholds &thresholds,
+                                                     int cameraId)
+{
+    constexpr int maxAttempts = 3;
+    for (int attempt = 0; attempt < maxAttempts; ++attempt) {
+        FrameRing::FrameView view;
+        if (!ring.beginRead(slotIndex, &view)) {
+            // 書き込み中：ごく短時間で偶数へ戻るので少し待って読み直す
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            continue;
+        }
 
-    cv::Mat src = img(tgtRect).clone();
+        std::vector<Rect> results;
+        if (view.format == FrameRing::FormatBGR) {
+            // 共有メモリをそのまま指すMatヘッダを被せる
+            cv::Mat frame(view.height, view.width, CV_8UC3, (void *)view.data);
+            results = detectHeads(frame, vertices, thresholds, cameraId);
+        }
+        else {
+            results = detectHeads(view.data, view.size, vertices, thresholds,
+                                  cameraId);
+        }
+
+        if (ring.stillValid(slotIndex, view.sequence)) {
+            return results;
+        }
+        spdlog::warn("FrameRing slot {} was overwritten during detection; "
+                     "retrying",
+                     slotIndex);
+    }
+    spdlog::error("FrameRing slot {} could not be read consistently.",
+                  slotIndex);
+    return std::vector<Rect>();
+}
+
+std::vector<Rect> PersonCounter::detectOnFrame(const DecodedFrame &frame,
+                                               double decodeMs,
+                                               size_t inputBytes,
+                                               std::vector<OBJPos> &vertices,
+                                               Thresholds &thresholds,
+                                               int cameraId)
+{
+    cv::Mat img = frame.image;
+
+    // 頂点列からROI（元画像座標）を求め、デコード座標系（縮小・オフセット
+    // 適用後）へ変換する。頂点列が空の場合は全画面を対象とする
+    cv::Rect tgtRect(0, 0, img.cols, img.rows);
+    if (!vertices.empty()) {
+        cv::Rect fullRoi = getTgtRect(vertices, INT_MAX, INT_MAX);
+        tgtRect = cv::Rect((fullRoi.x - frame.offsetX) / frame.scaleDenom,
+                           (fullRoi.y - frame.offsetY) / frame.scaleDenom,
+                           fullRoi.width / frame.scaleDenom,
+                           fullRoi.height / frame.scaleDenom);
+        tgtRect &= cv::Rect(0, 0, img.cols, img.rows);
+    }
+    if (tgtRect.width <= 0 || tgtRect.height <= 0) {
+        spdlog::error("Target region is empty.");
+        return std::vector<Rect>();
+    }
+
+    // 静止シーン判定：基準フレームとの差分が閾値未満なら推論をスキップし、
+    // キャッシュ済みの前回結果をそのまま返す
+    bool useGate = motionGateEnabled && cameraId >= 0;
+    if (useGate
+        && !motionGate.shouldRun(cameraId, img(tgtRect), motionThreshold)) {
+        std::vector<Rect> cached = motionGate.cachedResult(cameraId);
+        spdlog::trace("Motion gate: static scene, returning {} cached results",
+                      cached.size());
+
+        PipelineStats sample;
+        sample.decodeMs = decodeMs;
+        sample.detections = (int)cached.size();
+        sample.inputBytes = inputBytes;
+        StatsRegistry::instance().record(sample);
+        CountAggregator::instance().record(cameraId, (int)cached.size());
+        return cached;
+    }
 
     // set thresholds
-    inf->setThresholds(thresholds.confidenceThreshold, thresholds.scoreThreshold,
-                       thresholds.nmsThreshold);
+    // スケジューラ経由の実行では直接設定しない：バッチ実行は閾値を
+    // submit()で運びスケジューラスレッドだけが適用し、マルチGPU実行は
+    // レプリカのロックを取った上で設定する。ここで設定するとinfが
+    // 共有Inference（プール経由ではレプリカ0）を指すため、実行中の
+    // 他リクエストと競合する
+    if (!batchScheduler && !deviceScheduler) {
+        inf->setThresholds(thresholds.confidenceThreshold,
+                           thresholds.scoreThreshold, thresholds.nmsThreshold,
+                           thresholds.maxDetections);
+    }
 
     // Inference starts here...
-    std::vector<Detection> output = inf->runInference(src);
+    // 対象領域はビューのまま渡し、クローンによるコピーを回避する
+    std::vector<Detection> output;
+    if (batchScheduler) {
+        // 収集ウィンドウ内の他リクエストとまとめてバッチ実行される
+        output = batchScheduler
+                     ->submit(img(tgtRect), thresholds.confidenceThreshold,
+                              thresholds.scoreThreshold,
+                              thresholds.nmsThreshold, thresholds.maxDetections)
+                     .get();
+    }
+    else if (deviceScheduler) {
+        // 最も空いているGPUレプリカへ振り分ける
+        size_t replica;
+        Inference *dev = deviceScheduler->acquire(&replica);
+        try {
+            dev->setThresholds(thresholds.confidenceThreshold,
+                               thresholds.scoreThreshold,
+                               thresholds.nmsThreshold,
+                               thresholds.maxDetections);
+            output = dev->runInference(img, tgtRect);
+        }
+        catch (...) {
+            deviceScheduler->release(replica);
+            throw;
+        }
+        deviceScheduler->release(replica);
+    }
+    else if (tiledEnabled) {
+        // 広域ROIを重なり付きタイルへ分割してバッチ推論する
+        output = inf->runInferenceTiled(img, tgtRect, tileOverlap);
+    }
+    else {
+        output = inf->runInference(img, tgtRect);
+    }
 
     int detections = output.size();
     spdlog::trace("Number of detections: {}", detections);
 
+    // 多角形による厳密な内外判定（外接矩形内でも多角形外の検出を除外）
+    bool usePolygon = vertices.size() >= 3;
+    if (usePolygon && !polygonFilter.matches(vertices)) {
+        polygonFilter.build(vertices);
+    }
+
     std::vector<Rect> results;
 
     for (int i = 0; i < detections; ++i) {
@@ -121,15 +633,49 @@ std::vector<Rect> PersonCounter::detectHeads(std::vector<unsigned char> &jpegDat
         cv::Rect box = detection.box;
 
         Rect result;
-        result.x = box.x + tgtRect.x; // Adjust for the cropped region
-        result.y = box.y + tgtRect.y; // Adjust for the cropped region
-        result.width = box.width;
-        result.height = box.height;
+        // 切り出し位置・縮小率・部分デコードのオフセットを元画像座標へ戻す
+        result.x = (box.x + tgtRect.x) * frame.scaleDenom + frame.offsetX;
+        result.y = (box.y + tgtRect.y) * frame.scaleDenom + frame.offsetY;
+        result.width = box.width * frame.scaleDenom;
+        result.height = box.height * frame.scaleDenom;
         result.confidence = detection.confidence;
         // cv::Scalar color = detection.color;
 
+        // 検出中心が多角形の外なら除外する
+        if (usePolygon
+            && !polygonFilter.contains(result.x + result.width * 0.5f,
+                                       result.y + result.height * 0.5f)) {
+            continue;
+        }
+
         results.push_back(result);
     }
 
+    // トラッキング有効時：検出結果をトラックへ対応付け、ID付きの結果に
+    // 置き換える
+    if (tracker && cameraId >= 0) {
+        results = tracker->update(cameraId, results);
+    }
+
+    // 次フレームの静止シーン判定で返せるよう結果をキャッシュする
+    if (useGate) {
+        motionGate.storeResult(cameraId, results);
+    }
+
+    // 各段の時間を統計レジストリへ記録する
+    // バッチ・マルチGPU実行時は共有Inferenceの計測値が他リクエストと
+    // 混ざるため、デコード時間と件数のみを記録する
+    PipelineStats sample;
+    if (!batchScheduler && !deviceScheduler) {
+        sample = inf->lastTimings();
+    }
+    sample.decodeMs = decodeMs;
+    sample.detections = (int)results.size();
+    sample.inputBytes = inputBytes;
+    StatsRegistry::instance().record(sample);
+
+    // カメラ単位の人数時系列へ記録する（cameraId指定時のみ）
+    CountAggregator::instance().record(cameraId, (int)results.size());
+
     return results;
 }
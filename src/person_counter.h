@@ -19,12 +19,21 @@
 
 #ifndef __PERSON_COUNTER_H__
 #define __PERSON_COUNTER_H__
+#include <list>
+#include <map>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <opencv2/opencv.hpp>
 
 #include "inference.h"
+#include "jpeg_decoder.h"
+
+class BatchScheduler;
+class DeviceScheduler;
+class FrameRing;
+class HeadTracker;
 
 // 頭部領域矩形データ構造体
 struct Rect
@@ -34,11 +43,16 @@ struct Rect
     int width;        // 幅
     int height;       // 高さ
     float confidence; // 信頼度
-    Rect() : x(0), y(0), width(0), height(0), confidence(0.0f)
+    int trackId;      // トラックID（トラッキング無効時は-1）
+    bool tracked; // trueなら検出ではなくトラッカの外挿によるボックス
+    Rect()
+        : x(0), y(0), width(0), height(0), confidence(0.0f), trackId(-1),
+          tracked(false)
     {
     }
     Rect(int x_, int y_, int w_, int h_, float c_)
-        : x(x_), y(y_), width(w_), height(h_), confidence(c_)
+        : x(x_), y(y_), width(w_), height(h_), confidence(c_), trackId(-1),
+          tracked(false)
     {
     }
 };
@@ -66,25 +80,215 @@ struct Thresholds
     float confidenceThreshold; // 信頼度の閾値
     float scoreThreshold;      // スコアの閾値
     float nmsThreshold;        // 非最大抑制の閾値
+    int maxDetections;         // 検出数の上限（NMSの最悪時間を抑える）
 
-    Thresholds(float conf = 0.2, float score = 0.2, float nms = 0.2)
-        : confidenceThreshold(conf), scoreThreshold(score), nmsThreshold(nms)
+    Thresholds(float conf = 0.2, float score = 0.2, float nms = 0.2,
+               int maxDet = 300)
+        : confidenceThreshold(conf), scoreThreshold(score), nmsThreshold(nms),
+          maxDetections(maxDet)
     {
     }
 };
 
+// 多角形内外判定フィルタ
+// 頂点列からエッジテーブルを事前計算し、交差数判定（even-odd規則）で
+// 点の内外を判定する。頂点列をキーとしてキャッシュされ、同じ多角形が
+// 続く限り再構築しない
+class PolygonFilter
+{
+  public:
+    // 頂点列からエッジテーブルを構築する
+    void build(const std::vector<OBJPos> &verts);
+
+    // キャッシュ済みの頂点列と一致するか
+    bool matches(const std::vector<OBJPos> &verts) const;
+
+    // 点(px, py)が多角形の内側にあるか
+    bool contains(float px, float py) const;
+
+  private:
+    // 交差判定用エッジ（y0 <= y1 に正規化済み）
+    struct Edge
+    {
+        float y0;    // 下端Y
+        float y1;    // 上端Y
+        float x0;    // y0におけるX
+        float slope; // dx/dy
+    };
+
+    std::vector<OBJPos> vertices; // キャッシュキー
+    std::vector<Edge> edges;      // エッジテーブル
+};
+
+// 検出結果のLRUキャッシュ
+// 入力フレームのバイト列・頂点列・閾値から計算した64bitハッシュをキーに、
+// 検出結果を保持する。同一JPEGを数秒間返し続けるカメラのポーリングで、
+// バイト単位で同一の入力の再デコード・再推論を丸ごと省く
+class ResultCache
+{
+  public:
+    explicit ResultCache(size_t capacity = 64);
+
+    // キーに対応する結果があればresultへコピーしてtrue（エントリは最新化）
+    bool lookup(uint64_t key, std::vector<Rect> &result);
+
+    // 結果を保存する。容量超過時は最も古いエントリを破棄する
+    void store(uint64_t key, const std::vector<Rect> &result);
+
+  private:
+    struct Entry
+    {
+        uint64_t key;
+        std::vector<Rect> result;
+    };
+
+    size_t capacity;
+    std::list<Entry> entries; // 先頭が最近使用
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+};
+
+// 静止シーン判定ゲート
+// カメラごとに縮小グレースケールの基準フレームを保持し、現フレームとの
+// 平均絶対差分（SAD）が閾値未満なら「シーンに動きなし」と判定する。
+// 動きがない間は前回の検出結果を返し、推論自体をスキップする。
+// 基準フレームは推論を実行したときのみ更新するため、緩やかな変化も
+// いずれ閾値を超えて推論が走る
+class MotionGate
+{
+  public:
+    // ROIと基準フレームの差分が閾値以上（＝推論が必要）ならtrue。
+    // trueを返した場合は基準フレームを現フレームで置き換える
+    bool shouldRun(int cameraId, const cv::Mat &roi, double threshold);
+
+    // 推論結果をカメラのキャッシュへ保存する
+    void storeResult(int cameraId, const std::vector<Rect> &results);
+
+    // キャッシュ済みの前回結果を返す
+    const std::vector<Rect> &cachedResult(int cameraId);
+
+  private:
+    // 差分計算用の縮小サイズ（1辺）
+    static constexpr int downsampleSize = 64;
+
+    struct CameraState
+    {
+        cv::Mat reference;            // 縮小グレースケールの基準フレーム
+        std::vector<Rect> lastResult; // 前回の検出結果（元画像座標）
+        bool hasResult = false;       // 結果キャッシュが有効か
+    };
+
+    std::map<int, CameraState> cameras; // カメラIDごとの状態
+    cv::Mat gray;                       // 再利用バッファ
+    cv::Mat small;                      // 再利用バッファ
+};
+
 class PersonCounter
 {
   public:
     PersonCounter();
+    // ログ初期化を行わず、外部で生成したInferenceを使用するコンストラクタ
+    // （PersonCounterPoolのワーカー用）
+    explicit PersonCounter(std::shared_ptr<Inference> inference);
     ~PersonCounter();
 
+    // 既定のモデル設定でInferenceインスタンスを生成
+    // deviceIdで推論を実行するCUDAデバイスを指定できる（既定は0）
+    static std::shared_ptr<Inference> createDefaultInference(int deviceId = 0);
+
+    // ダミーフレームで推論を実行し、初回リクエストの遅延初期化コストを
+    // 事前に払う。backgroundをtrueにするとバックグラウンドで実行する
+    void warmup(int iterations = 1, bool background = false);
+
+    // バッチスケジューラを設定すると、推論は共有Inferenceへの
+    // マイクロバッチとして実行される（複数インスタンス間でGPUを共有する場合）
+    void setBatchScheduler(std::shared_ptr<BatchScheduler> scheduler);
+
+    // デバイススケジューラを設定すると、推論は最も空いている
+    // GPUレプリカへ振り分けられる（マルチGPUホスト用）
+    void setDeviceScheduler(std::shared_ptr<DeviceScheduler> scheduler);
+
+    // 適応入力解像度を有効化する（入口カメラなど小さいROI向け）。
+    // 指定した入力サイズごとのネットをロード時に構築し、リクエストの
+    // ROI寸法を覆う最小のサイズで推論する。前フレームの検出数が
+    // densityPromoteAt以上なら1段大きいサイズへ昇格する（0で無効）
+    void setAdaptiveShapes(bool enabled,
+                           const std::vector<int> &sides = {320, 480, 640},
+                           int densityPromoteAt = 8);
+
+    // タイル分割推論を有効化する（4K広域カメラ向け）。
+    // ROIをモデル入力サイズの重なり付きタイルへ分割してバッチ推論し、
+    // グローバルNMSで統合する。小さいROIでは通常の1パス推論になる
+    void setTiledMode(bool enabled, float overlap = 0.2f);
+
+    // 入力バイト列をキーにした結果キャッシュを有効化する。
+    // 同一のJPEG・頂点列・閾値の組に対してはデコードも推論も行わず
+    // 保存済みの結果を返す。ヒット／ミスは統計レジストリに記録される
+    void setResultCache(bool enabled, size_t capacity = 64);
+
+    // フレーム間トラッキングを有効化する（cameraId指定の呼び出しでのみ作用）。
+    // detectEveryフレームに1回だけ検出を実行し、その間は等速度モデルで
+    // ボックスを外挿して返す。結果にはトラックIDとtrackedフラグが付く
+    void setTracking(bool enabled, int detectEvery = 5,
+                     float iouThreshold = 0.3f, int maxMissed = 3);
+
+    // 静止シーン判定による推論スキップを有効化する。
+    // cameraIdを指定したdetectHeads呼び出しでのみ作用する。
+    // thresholdは縮小グレースケールの画素あたり平均絶対差分（0〜255）
+    void setMotionGate(bool enabled, double threshold = 3.0);
+
     // 人物頭部検出実行
+    // cameraIdを指定する（>= 0）と、静止シーンゲートが有効な場合に
+    // カメラ単位で前フレームとの差分判定・結果キャッシュが行われる
     std::vector<Rect> detectHeads(std::vector<unsigned char> &jpegData,
                                   std::vector<OBJPos> &vertices,
-                                  Thresholds &thresholds);
+                                  Thresholds &thresholds, int cameraId = -1);
+
+    // 人物頭部検出実行（コピーなしのバッファ参照版）
+    std::vector<Rect> detectHeads(const unsigned char *jpegData, size_t jpegSize,
+                                  std::vector<OBJPos> &vertices,
+                                  Thresholds &thresholds, int cameraId = -1);
+
+    // 人物頭部検出実行（デコード済みフレーム版）
+    // RTSP取り込みなど、JPEGを経由せずBGRフレームを直接渡す経路用
+    std::vector<Rect> detectHeads(const cv::Mat &image,
+                                  std::vector<OBJPos> &vertices,
+                                  Thresholds &thresholds, int cameraId = -1);
+
+    // 人物頭部検出実行（共有メモリリング版）
+    // リングのスロットを共有メモリ上で直接参照して検出する（コピーなし）。
+    // 検出中にプロデューサがスロットを上書きした場合は読み直す
+    std::vector<Rect> detectHeadsFromRing(FrameRing &ring, uint64_t slotIndex,
+                                          std::vector<OBJPos> &vertices,
+                                          Thresholds &thresholds,
+                                          int cameraId = -1);
+
+    // 人物頭部検出実行（numpyバインディング用の平坦な配列版）
+    // 検出ごとに (x, y, width, height, confidence) の5要素を連続して格納する
+    std::vector<float> detectHeadsFlat(const unsigned char *jpegData,
+                                       size_t jpegSize,
+                                       std::vector<OBJPos> &vertices,
+                                       Thresholds &thresholds, int cameraId = -1);
 
   private:
+    // デコード後の共通パイプライン（ROI切り出し・推論・多角形判定・
+    // 元画像座標への復元・統計記録）
+    std::vector<Rect> detectOnFrame(const DecodedFrame &frame, double decodeMs,
+                                    size_t inputBytes,
+                                    std::vector<OBJPos> &vertices,
+                                    Thresholds &thresholds, int cameraId);
+
     std::shared_ptr<Inference> inf; // yolov8 head detection class
+    JpegDecoder decoder;            // ROI対応JPEGデコーダ
+    std::shared_ptr<BatchScheduler> batchScheduler; // 任意のバッチ実行経路
+    std::shared_ptr<DeviceScheduler> deviceScheduler; // 任意のマルチGPU経路
+    PolygonFilter polygonFilter; // 多角形内外判定（頂点列でキャッシュ）
+    MotionGate motionGate;       // 静止シーン判定（カメラIDごと）
+    bool motionGateEnabled = false; // 静止シーンゲートを使用するか
+    double motionThreshold = 3.0;   // 動きありと判定する平均差分の閾値
+    bool tiledEnabled = false;      // タイル分割推論を使用するか
+    float tileOverlap = 0.2f;       // 隣接タイルの重なり率
+    std::shared_ptr<HeadTracker> tracker; // フレーム間トラッカ（任意）
+    ResultCache resultCache;        // 入力バイト列キーの結果キャッシュ
+    bool resultCacheEnabled = false; // 結果キャッシュを使用するか
 };
 #endif
\ No newline at end of file
@@ -17,9 +17,15 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include "camera_ingest.h"
+#include "count_aggregator.h"
+#include "frame_ring.h"
 #include "person_counter.h"
+#include "person_counter_pool.h"
+#include "pipeline_stats.h"
 
 #include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
 #include <pybind11/stl.h>
 namespace py = pybind11;
 
@@ -36,6 +42,8 @@ PyMODINIT_FUNC PyInit_PersonCounterModule()
         .def_readwrite("width", &Rect::width)
         .def_readwrite("height", &Rect::height)
         .def_readwrite("confidence", &Rect::confidence)
+        .def_readwrite("trackId", &Rect::trackId)
+        .def_readwrite("tracked", &Rect::tracked)
         .def(
             "to_dict",
             [](const Rect &rect) {
@@ -45,6 +53,8 @@ PyMODINIT_FUNC PyInit_PersonCounterModule()
                 result["width"] = rect.width;
                 result["height"] = rect.height;
                 result["confidence"] = rect.confidence;
+                result["trackId"] = rect.trackId;
+                result["tracked"] = rect.tracked;
                 return result;
             },
             "Convert Rect to dictionary");
@@ -64,11 +74,13 @@ PyMODINIT_FUNC PyInit_PersonCounterModule()
             },
             "Convert OBJPos to dictionary");
     py::class_<Thresholds>(m, "Thresholds")
-        .def(py::init<float, float, float>(), py::arg("confidenceThreshold"),
-             py::arg("scoreThreshold"), py::arg("nmsThreshold"))
+        .def(py::init<float, float, float, int>(),
+             py::arg("confidenceThreshold"), py::arg("scoreThreshold"),
+             py::arg("nmsThreshold"), py::arg("maxDetections") = 300)
         .def_readwrite("confidenceThreshold", &Thresholds::confidenceThreshold)
         .def_readwrite("scoreThreshold", &Thresholds::scoreThreshold)
         .def_readwrite("nmsThreshold", &Thresholds::nmsThreshold)
+        .def_readwrite("maxDetections", &Thresholds::maxDetections)
         .def(
             "to_dict",
             [](const Thresholds &thresholds) {
@@ -76,15 +88,281 @@ PyMODINIT_FUNC PyInit_PersonCounterModule()
                 result["confidenceThreshold"] = thresholds.confidenceThreshold;
                 result["scoreThreshold"] = thresholds.scoreThreshold;
                 result["nmsThreshold"] = thresholds.nmsThreshold;
+                result["maxDetections"] = thresholds.maxDetections;
                 return result;
             },
             "Convert Thresholds to dictionary");
 
     py::class_<PersonCounter>(m, "PersonCounter")
         .def(py::init<>())
-        .def("detectHeads", &PersonCounter::detectHeads, py::arg("jpegData"),
+        .def("warmup", &PersonCounter::warmup, py::arg("iterations") = 1,
+             py::arg("background") = false,
+             py::call_guard<py::gil_scoped_release>(),
+             "Run dummy frames through the network so the first request does "
+             "not pay lazy initialization costs.")
+        .def("setAdaptiveShapes", &PersonCounter::setAdaptiveShapes,
+             py::arg("enabled"),
+             py::arg("sides") = std::vector<int>{320, 480, 640},
+             py::arg("densityPromoteAt") = 8,
+             "Load one network per input side and pick the smallest one that "
+             "covers each request's ROI; scenes with densityPromoteAt or more "
+             "heads in the previous frame are promoted one size up.")
+        .def("setTiledMode", &PersonCounter::setTiledMode, py::arg("enabled"),
+             py::arg("overlap") = 0.2f,
+             "Split large ROIs into overlapping model-sized tiles, run them as "
+             "one batched forward and merge the results with a global NMS.")
+        .def("setResultCache", &PersonCounter::setResultCache,
+             py::arg("enabled"), py::arg("capacity") = 64,
+             "Cache detection results keyed on the frame bytes, vertices and "
+             "thresholds so byte-identical inputs skip decode and inference.")
+        .def("setTracking", &PersonCounter::setTracking, py::arg("enabled"),
+             py::arg("detectEvery") = 5, py::arg("iouThreshold") = 0.3f,
+             py::arg("maxMissed") = 3,
+             "Run full detection every detectEvery-th frame per camera and "
+             "extrapolate tracked boxes in between; results carry stable "
+             "track ids and a tracked flag.")
+        .def("setMotionGate", &PersonCounter::setMotionGate, py::arg("enabled"),
+             py::arg("threshold") = 3.0,
+             "Enable or disable inference skipping on static scenes. Only "
+             "affects detectHeads calls that pass a non-negative cameraId.")
+        .def(
+            "detectHeads",
+            [](PersonCounter &counter, py::buffer jpegData,
+               std::vector<OBJPos> vertices, Thresholds thresholds,
+               int cameraId) {
+                // bytes/bytearray/memoryviewをコピーせずに参照する
+                py::buffer_info info = jpegData.request();
+                const unsigned char *data =
+                    static_cast<const unsigned char *>(info.ptr);
+                size_t size = (size_t)info.size * (size_t)info.itemsize;
+                // 推論中は他のPythonスレッドを動かせるようGILを解放する
+                py::gil_scoped_release release;
+                return counter.detectHeads(data, size, vertices, thresholds,
+                                           cameraId);
+            },
+            py::arg("jpegData"), py::arg("vertices"),
+            py::arg("thresholds") = Thresholds(), py::arg("cameraId") = -1,
+            "Detect heads in the given JPEG data using the specified vertices and "
+            "thresholds.")
+        .def(
+            "detectHeadsNumpy",
+            [](PersonCounter &counter, py::buffer jpegData,
+               std::vector<OBJPos> vertices, Thresholds thresholds,
+               int cameraId) {
+                py::buffer_info info = jpegData.request();
+                const unsigned char *data =
+                    static_cast<const unsigned char *>(info.ptr);
+                size_t size = (size_t)info.size * (size_t)info.itemsize;
+
+                std::vector<float> flat;
+                {
+                    py::gil_scoped_release release;
+                    flat = counter.detectHeadsFlat(data, size, vertices,
+                                                   thresholds, cameraId);
+                }
+
+                // C++バッファの所有権をcapsuleへ移し、コピーせずに
+                // (N, 5) float32 配列として返す
+                py::ssize_t n = (py::ssize_t)(flat.size() / 5);
+                auto *holder = new std::vector<float>(std::move(flat));
+                py::capsule owner(holder, [](void *p) {
+                    delete reinterpret_cast<std::vector<float> *>(p);
+                });
+                return py::array_t<float>(
+                    {n, (py::ssize_t)5},
+                    {(py::ssize_t)(5 * sizeof(float)), (py::ssize_t)sizeof(float)},
+                    holder->data(), owner);
+            },
+            py::arg("jpegData"), py::arg("vertices"),
+            py::arg("thresholds") = Thresholds(), py::arg("cameraId") = -1,
+            "Detect heads and return the results as one (N, 5) float32 array "
+            "of (x, y, width, height, confidence) rows.")
+        .def("detectHeadsFromRing", &PersonCounter::detectHeadsFromRing,
+             py::arg("ring"), py::arg("slotIndex"), py::arg("vertices"),
+             py::arg("thresholds") = Thresholds(), py::arg("cameraId") = -1,
+             py::call_guard<py::gil_scoped_release>(),
+             "Detect heads on a shared-memory ring slot without copying the "
+             "frame out of the ring.");
+
+    py::class_<PersonCounterPool>(m, "PersonCounterPool")
+        .def(py::init<int, int, std::vector<int>, int>(),
+             py::arg("numWorkers") = 2, py::arg("batchSize") = 0,
+             py::arg("deviceIds") = std::vector<int>(),
+             py::arg("replicasPerDevice") = 1,
+             "Pass deviceIds (e.g. [0, 1]) to create inference replicas on "
+             "multiple GPUs; requests are dispatched to the least-loaded "
+             "replica. Takes precedence over batchSize.")
+        .def("submit", &PersonCounterPool::submit, py::arg("jpegData"),
              py::arg("vertices"), py::arg("thresholds") = Thresholds(),
-             "Detect heads in the given JPEG data using the specified vertices and "
-             "thresholds.");
+             py::call_guard<py::gil_scoped_release>(),
+             "Submit a detection job and return its job id.")
+        .def(
+            "poll",
+            [](PersonCounterPool &pool, uint64_t jobId) -> py::object {
+                std::vector<Rect> result;
+                bool done;
+                {
+                    py::gil_scoped_release release;
+                    done = pool.poll(jobId, result);
+                }
+                if (!done) {
+                    return py::none();
+                }
+                return py::cast(result);
+            },
+            py::arg("jobId"),
+            "Return the result list if the job has completed, otherwise None.")
+        .def("wait", &PersonCounterPool::wait, py::arg("jobId"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Block until the job completes and return the result list.")
+        .def("pendingJobs", &PersonCounterPool::pendingJobs,
+             "Number of jobs waiting in the queue.");
+
+    py::class_<FrameRing>(m, "FrameRing")
+        .def(py::init<const std::string &, size_t, size_t, bool>(),
+             py::arg("name"), py::arg("slotCount") = 8,
+             py::arg("slotSize") = (size_t)(4u << 20), py::arg("create") = true,
+             "Create (or attach to, with create=False) a POSIX shared-memory "
+             "frame ring that co-located producers can write into.")
+        .def_property_readonly("name", &FrameRing::name)
+        .def_property_readonly("slotCount", &FrameRing::slotCount)
+        .def_property_readonly("slotSize", &FrameRing::slotSize)
+        .def(
+            "write",
+            [](FrameRing &ring, py::buffer data, int format, int width,
+               int height) {
+                py::buffer_info info = data.request();
+                const unsigned char *ptr =
+                    static_cast<const unsigned char *>(info.ptr);
+                size_t size = (size_t)info.size * (size_t)info.itemsize;
+                py::gil_scoped_release release;
+                return ring.write(ptr, size, format, width, height);
+            },
+            py::arg("data"), py::arg("format") = FrameRing::FormatJPEG,
+            py::arg("width") = 0, py::arg("height") = 0,
+            "Write one frame into the next slot and return its slot index.");
+    m.attr("FRAME_FORMAT_JPEG") = FrameRing::FormatJPEG;
+    m.attr("FRAME_FORMAT_BGR") = FrameRing::FormatBGR;
+
+    py::class_<CameraIngest>(m, "CameraIngest")
+        .def(py::init<int>(), py::arg("batchSize") = 0)
+        .def(
+            "setCallback",
+            [](CameraIngest &ingest, py::function callback) {
+                ingest.setCallback([callback](int cameraId, double timestampSec,
+                                              const std::vector<Rect> &heads) {
+                    // コールバックはカメラスレッドから呼ばれるためGILを取得する
+                    py::gil_scoped_acquire acquire;
+                    callback(cameraId, timestampSec, heads);
+                });
+            },
+            py::arg("callback"),
+            "Register a callable(cameraId, timestampSec, heads) invoked from "
+            "the camera threads for each processed frame.")
+        .def(
+            "addCamera",
+            [](CameraIngest &ingest, int cameraId, const std::string &url,
+               double sampleFps, std::vector<OBJPos> vertices,
+               Thresholds thresholds) {
+                CameraConfig config;
+                config.cameraId = cameraId;
+                config.url = url;
+                config.sampleFps = sampleFps;
+                config.vertices = std::move(vertices);
+                config.thresholds = thresholds;
+                py::gil_scoped_release release;
+                ingest.addCamera(config);
+            },
+            py::arg("cameraId"), py::arg("url"), py::arg("sampleFps") = 5.0,
+            py::arg("vertices") = std::vector<OBJPos>(),
+            py::arg("thresholds") = Thresholds(),
+            "Start ingesting the given RTSP stream, decoding frames directly "
+            "into the detection pipeline at the requested sampling rate. An "
+            "empty vertices list means the full frame is the detection "
+            "region.")
+        .def("removeCamera", &CameraIngest::removeCamera, py::arg("cameraId"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Stop and remove one camera.")
+        .def("stop", &CameraIngest::stop,
+             py::call_guard<py::gil_scoped_release>(),
+             "Stop all camera threads. Call this before dropping the object "
+             "so worker threads are not joined while the GIL is held.");
+
+    m.def(
+        "getStats",
+        []() {
+            StatsRegistry::Snapshot snap = StatsRegistry::instance().snapshot();
+            py::dict result;
+            result["frames"] = snap.frames;
+            result["decode_ms_total"] = snap.decodeMsTotal;
+            result["preprocess_ms_total"] = snap.preprocessMsTotal;
+            result["forward_ms_total"] = snap.forwardMsTotal;
+            result["postprocess_ms_total"] = snap.postprocessMsTotal;
+            result["detections_total"] = snap.detectionsTotal;
+            result["input_bytes_total"] = snap.inputBytesTotal;
+            result["cache_hits"] = snap.cacheHits;
+            result["cache_misses"] = snap.cacheMisses;
+            py::list histogram;
+            for (auto count : snap.latencyHistogram) {
+                histogram.append(count);
+            }
+            // バケットiは総処理時間 [2^i, 2^(i+1)) ms の件数
+            result["latency_histogram"] = histogram;
+            return result;
+        },
+        "Aggregated per-stage pipeline statistics since start or last reset.");
+    m.def(
+        "resetStats", []() { StatsRegistry::instance().reset(); },
+        "Reset all pipeline statistics counters to zero.");
+    m.def(
+        "getCurrentCount",
+        [](int cameraId) {
+            return CountAggregator::instance().currentCount(cameraId);
+        },
+        py::arg("cameraId"),
+        "Most recent head count recorded for the camera, or -1 if the "
+        "camera has no samples yet. O(1); safe to poll at high rates.");
+    m.def(
+        "getCountMin",
+        [](int cameraId, double seconds) {
+            int lo, hi;
+            double mean;
+            if (!CountAggregator::instance().windowStats(cameraId, seconds,
+                                                         &lo, &hi, &mean)) {
+                return -1;
+            }
+            return lo;
+        },
+        py::arg("cameraId"), py::arg("seconds"),
+        "Minimum head count for the camera over the last N seconds, or -1 "
+        "if no samples fall in the window.");
+    m.def(
+        "getCountMax",
+        [](int cameraId, double seconds) {
+            int lo, hi;
+            double mean;
+            if (!CountAggregator::instance().windowStats(cameraId, seconds,
+                                                         &lo, &hi, &mean)) {
+                return -1;
+            }
+            return hi;
+        },
+        py::arg("cameraId"), py::arg("seconds"),
+        "Maximum head count for the camera over the last N seconds, or -1 "
+        "if no samples fall in the window.");
+    m.def(
+        "getCountMean",
+        [](int cameraId, double seconds) {
+            int lo, hi;
+            double mean;
+            if (!CountAggregator::instance().windowStats(cameraId, seconds,
+                                                         &lo, &hi, &mean)) {
+                return -1.0;
+            }
+            return mean;
+        },
+        py::arg("cameraId"), py::arg("seconds"),
+        "Mean head count for the camera over the last N seconds, or -1.0 "
+        "if no samples fall in the window.");
     return m.ptr();
 }
\ No newline at end of file
@@ -0,0 +1,182 @@
+/*
+ * This file is part of [Head Count Web Application].
+ *
+ * Copyright (C) 2025 TakumiVision co., ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "person_counter_pool.h"
+
+#include <stdexcept>
+
+#include <spdlog/spdlog.h>
+
+#include "batch_scheduler.h"
+#include "device_scheduler.h"
+
+PersonCounterPool::PersonCounterPool(int numWorkers, int batchSize,
+                                     std::vector<int> deviceIds,
+                                     int replicasPerDevice)
+{
+    if (numWorkers < 1) {
+        numWorkers = 1;
+    }
+
+    // マルチGPUモード：デバイスごとにInferenceレプリカを生成し、
+    // 推論を最も空いているレプリカへ振り分ける
+    if (!deviceIds.empty()) {
+        deviceScheduler = std::make_shared<DeviceScheduler>(
+            deviceIds, replicasPerDevice, [](int deviceId) {
+                return PersonCounter::createDefaultInference(deviceId);
+            });
+    }
+    // バッチモード：1つのInferenceを全ワーカーで共有し、推論は
+    // マイクロバッチとしてまとめて実行する（デコードはワーカーで並列）
+    else if (batchSize > 0) {
+        sharedInference = PersonCounter::createDefaultInference();
+        scheduler = std::make_shared<BatchScheduler>(sharedInference, batchSize);
+    }
+
+    // 各ワーカーが専用のInferenceを持つため、モデルのロードは
+    // ワーカースレッド側で並列に行う
+    for (int i = 0; i < numWorkers; ++i) {
+        workers.emplace_back(&PersonCounterPool::workerLoop, this);
+    }
+}
+
+PersonCounterPool::~PersonCounterPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    jobAvailable.notify_all();
+    for (auto &&worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+uint64_t PersonCounterPool::submit(std::vector<unsigned char> jpegData,
+                                   std::vector<OBJPos> vertices,
+                                   Thresholds thresholds)
+{
+    uint64_t id;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        id = nextJobId++;
+        active.insert(id);
+        DetectJob job;
+        job.id = id;
+        job.jpegData = std::move(jpegData);
+        job.vertices = std::move(vertices);
+        job.thresholds = thresholds;
+        jobQueue.push_back(std::move(job));
+    }
+    jobAvailable.notify_one();
+    return id;
+}
+
+bool PersonCounterPool::poll(uint64_t jobId, std::vector<Rect> &result)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = completed.find(jobId);
+    if (it == completed.end()) {
+        return false;
+    }
+    result = std::move(it->second);
+    completed.erase(it);
+    active.erase(jobId);
+    return true;
+}
+
+std::vector<Rect> PersonCounterPool::wait(uint64_t jobId)
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    // 未登録・取得済みのIDで待つと永久にブロックするため先に検査する
+    if (active.find(jobId) == active.end()) {
+        throw std::invalid_argument(
+            "PersonCounterPool::wait: unknown or already retrieved job id");
+    }
+    jobCompleted.wait(lock,
+                      [&] { return completed.find(jobId) != completed.end(); });
+    std::vector<Rect> result = std::move(completed[jobId]);
+    completed.erase(jobId);
+    active.erase(jobId);
+    return result;
+}
+
+size_t PersonCounterPool::pendingJobs()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    return jobQueue.size();
+}
+
+void PersonCounterPool::workerLoop()
+{
+    // ワーカー専用のInference/PersonCounterを生成（ログ初期化は行わない）
+    // バッチ・マルチGPUモードでは共有Inferenceを使い、推論をスケジューラへ
+    // 委譲する（マルチGPUではワーカー専用のモデルロードを行わない）
+    std::shared_ptr<Inference> workerInference;
+    if (deviceScheduler) {
+        workerInference = deviceScheduler->replicaInference(0);
+    }
+    else if (sharedInference) {
+        workerInference = sharedInference;
+    }
+    else {
+        workerInference = PersonCounter::createDefaultInference();
+    }
+    PersonCounter counter(workerInference);
+    if (scheduler) {
+        counter.setBatchScheduler(scheduler);
+    }
+    if (deviceScheduler) {
+        counter.setDeviceScheduler(deviceScheduler);
+    }
+
+    while (true) {
+        DetectJob job;
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            jobAvailable.wait(lock,
+                              [&] { return stopping || !jobQueue.empty(); });
+            if (stopping && jobQueue.empty()) {
+                return;
+            }
+            job = std::move(jobQueue.front());
+            jobQueue.pop_front();
+        }
+
+        // ジョブ単位で例外を握りつぶす：デコード失敗や推論バックエンドの
+        // 例外でワーカー（＝プロセス）を落とさず、空の結果として完了させる
+        std::vector<Rect> result;
+        try {
+            result = counter.detectHeads(job.jpegData, job.vertices,
+                                         job.thresholds);
+        }
+        catch (const std::exception &e) {
+            spdlog::error("PersonCounterPool: job {} failed: {}", job.id,
+                          e.what());
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            completed[job.id] = std::move(result);
+        }
+        jobCompleted.notify_all();
+    }
+}
@@ -0,0 +1,90 @@
+/*
+ * This file is part of [Head Count Web Application].
+ *
+ * Copyright (C) 2025 TakumiVision co., ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __PERSON_COUNTER_POOL_H__
+#define __PERSON_COUNTER_POOL_H__
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "person_counter.h"
+
+class BatchScheduler;
+class DeviceScheduler;
+
+// 検出ジョブ構造体
+struct DetectJob
+{
+    uint64_t id;                         // ジョブID
+    std::vector<unsigned char> jpegData; // JPEG画像データ
+    std::vector<OBJPos> vertices;        // 検出対象領域の頂点座標
+    Thresholds thresholds;               // 検出閾値
+};
+
+// 複数のInferenceインスタンスを持つワーカープール
+// submit()でジョブを登録し、poll()で非同期に結果を取得する
+class PersonCounterPool
+{
+  public:
+    // batchSizeを1以上にすると、全ワーカーが1つのInferenceを共有し、
+    // 収集ウィンドウ内のジョブをマイクロバッチとして実行する。
+    // deviceIdsを指定すると、各デバイスにInferenceレプリカを生成し、
+    // 推論を最も空いているレプリカへ振り分ける（batchSizeより優先）
+    explicit PersonCounterPool(int numWorkers = 2, int batchSize = 0,
+                               std::vector<int> deviceIds = {},
+                               int replicasPerDevice = 1);
+    ~PersonCounterPool();
+
+    // ジョブを登録しジョブIDを返す（ノンブロッキング）
+    uint64_t submit(std::vector<unsigned char> jpegData,
+                    std::vector<OBJPos> vertices, Thresholds thresholds);
+
+    // 結果を取得する。完了していればtrueを返しresultに格納する
+    bool poll(uint64_t jobId, std::vector<Rect> &result);
+
+    // 結果が完了するまで待機して取得する。
+    // 未登録または取得済みのジョブIDにはstd::invalid_argumentを投げる
+    std::vector<Rect> wait(uint64_t jobId);
+
+    // キュー内の未処理ジョブ数
+    size_t pendingJobs();
+
+  private:
+    void workerLoop();
+
+    std::vector<std::thread> workers;      // ワーカースレッド
+    std::deque<DetectJob> jobQueue;        // 未処理ジョブキュー
+    std::unordered_map<uint64_t, std::vector<Rect>> completed; // 完了結果
+    std::unordered_set<uint64_t> active;   // 登録済みで未取得のジョブID
+    std::mutex mtx;                        // キュー・結果の排他制御
+    std::condition_variable jobAvailable;  // ジョブ到着通知
+    std::condition_variable jobCompleted;  // ジョブ完了通知
+    uint64_t nextJobId = 1;                // 次に割り当てるジョブID
+    bool stopping = false;                 // 終了フラグ
+    std::shared_ptr<Inference> sharedInference;  // バッチモード時の共有Inference
+    std::shared_ptr<BatchScheduler> scheduler;   // バッチモード時のスケジューラ
+    std::shared_ptr<DeviceScheduler> deviceScheduler; // マルチGPUモード時
+};
+#endif
@@ -0,0 +1,121 @@
+/*
+ * This file is part of [Head Count Web Application].
+ *
+ * Copyright (C) 2025 TakumiVision co., ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "pipeline_stats.h"
+
+StatsRegistry &StatsRegistry::instance()
+{
+    static StatsRegistry registry;
+    return registry;
+}
+
+StatsRegistry::ThreadSlot *StatsRegistry::slotForThisThread()
+{
+    // スレッドごとに1つのスロットを割り当てる。スロットはプロセス終了まで
+    // 生存する（スレッド終了後も集計値をスナップショットに含めるため）
+    thread_local ThreadSlot *slot = [this] {
+        auto *s = new ThreadSlot();
+        std::lock_guard<std::mutex> lock(registryMtx);
+        slots.push_back(s);
+        return s;
+    }();
+    return slot;
+}
+
+void StatsRegistry::record(const PipelineStats &sample)
+{
+    ThreadSlot *slot = slotForThisThread();
+    slot->frames.fetch_add(1, std::memory_order_relaxed);
+    slot->decodeUs.fetch_add((uint64_t)(sample.decodeMs * 1000.0),
+                             std::memory_order_relaxed);
+    slot->preprocessUs.fetch_add((uint64_t)(sample.preprocessMs * 1000.0),
+                                 std::memory_order_relaxed);
+    slot->forwardUs.fetch_add((uint64_t)(sample.forwardMs * 1000.0),
+                              std::memory_order_relaxed);
+    slot->postprocessUs.fetch_add((uint64_t)(sample.postprocessMs * 1000.0),
+                                  std::memory_order_relaxed);
+    slot->detections.fetch_add((uint64_t)sample.detections,
+                               std::memory_order_relaxed);
+    slot->inputBytes.fetch_add((uint64_t)sample.inputBytes,
+                               std::memory_order_relaxed);
+
+    // 総処理時間を2進対数バケットへ（1ms未満はバケット0）
+    double totalMs = sample.decodeMs + sample.preprocessMs + sample.forwardMs
+                     + sample.postprocessMs;
+    int bucket = 0;
+    while (bucket < histogramBuckets - 1 && totalMs >= (double)(2 << bucket)) {
+        ++bucket;
+    }
+    slot->histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void StatsRegistry::recordCacheHit()
+{
+    slotForThisThread()->cacheHits.fetch_add(1, std::memory_order_relaxed);
+}
+
+void StatsRegistry::recordCacheMiss()
+{
+    slotForThisThread()->cacheMisses.fetch_add(1, std::memory_order_relaxed);
+}
+
+StatsRegistry::Snapshot StatsRegistry::snapshot()
+{
+    Snapshot snap;
+    std::lock_guard<std::mutex> lock(registryMtx);
+    for (auto *slot : slots) {
+        snap.frames += slot->frames.load(std::memory_order_relaxed);
+        snap.decodeMsTotal +=
+            slot->decodeUs.load(std::memory_order_relaxed) / 1000.0;
+        snap.preprocessMsTotal +=
+            slot->preprocessUs.load(std::memory_order_relaxed) / 1000.0;
+        snap.forwardMsTotal +=
+            slot->forwardUs.load(std::memory_order_relaxed) / 1000.0;
+        snap.postprocessMsTotal +=
+            slot->postprocessUs.load(std::memory_order_relaxed) / 1000.0;
+        snap.detectionsTotal += slot->detections.load(std::memory_order_relaxed);
+        snap.inputBytesTotal += slot->inputBytes.load(std::memory_order_relaxed);
+        snap.cacheHits += slot->cacheHits.load(std::memory_order_relaxed);
+        snap.cacheMisses += slot->cacheMisses.load(std::memory_order_relaxed);
+        for (int i = 0; i < histogramBuckets; ++i) {
+            snap.latencyHistogram[i] +=
+                slot->histogram[i].load(std::memory_order_relaxed);
+        }
+    }
+    return snap;
+}
+
+void StatsRegistry::reset()
+{
+    std::lock_guard<std::mutex> lock(registryMtx);
+    for (auto *slot : slots) {
+        slot->frames.store(0, std::memory_order_relaxed);
+        slot->decodeUs.store(0, std::memory_order_relaxed);
+        slot->preprocessUs.store(0, std::memory_order_relaxed);
+        slot->forwardUs.store(0, std::memory_order_relaxed);
+        slot->postprocessUs.store(0, std::memory_order_relaxed);
+        slot->detections.store(0, std::memory_order_relaxed);
+        slot->inputBytes.store(0, std::memory_order_relaxed);
+        slot->cacheHits.store(0, std::memory_order_relaxed);
+        slot->cacheMisses.store(0, std::memory_order_relaxed);
+        for (int i = 0; i < histogramBuckets; ++i) {
+            slot->histogram[i].store(0, std::memory_order_relaxed);
+        }
+    }
+}
@@ -0,0 +1,104 @@
+/*
+ * This file is part of [Head Count Web Application].
+ *
+ * Copyright (C) 2025 TakumiVision co., ltd. All rights reserved.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __PIPELINE_STATS_H__
+#define __PIPELINE_STATS_H__
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// 1リクエスト分の各段の計測値
+struct PipelineStats
+{
+    double decodeMs;      // JPEGデコード時間
+    double preprocessMs;  // レターボックス・blob変換時間
+    double forwardMs;     // ネットワーク順伝播時間
+    double postprocessMs; // デコードループ・NMS時間
+    int detections;       // 検出数
+    size_t inputBytes;    // 入力JPEGバイト数
+
+    PipelineStats()
+        : decodeMs(0), preprocessMs(0), forwardMs(0), postprocessMs(0),
+          detections(0), inputBytes(0)
+    {
+    }
+};
+
+// プロセス全体の統計レジストリ
+// 記録はスレッドごとのスロットへのアトミック加算のみでロックを取らない。
+// スロットの登録（スレッド初回記録時）のみミューテックスで保護する。
+class StatsRegistry
+{
+  public:
+    // エンドツーエンド遅延ヒストグラムのバケット数（2進対数、1ms起点）
+    static constexpr int histogramBuckets = 16;
+
+    static StatsRegistry &instance();
+
+    // 1リクエスト分の計測値を記録する（ホットパス：ロックフリー）
+    void record(const PipelineStats &sample);
+
+    // 結果キャッシュのヒット／ミスを記録する（ロックフリー）
+    void recordCacheHit();
+    void recordCacheMiss();
+
+    // 全スレッド合算のスナップショット
+    struct Snapshot
+    {
+        uint64_t frames = 0;
+        double decodeMsTotal = 0;
+        double preprocessMsTotal = 0;
+        double forwardMsTotal = 0;
+        double postprocessMsTotal = 0;
+        uint64_t detectionsTotal = 0;
+        uint64_t inputBytesTotal = 0;
+        uint64_t cacheHits = 0;
+        uint64_t cacheMisses = 0;
+        // バケットiは総処理時間 [2^i, 2^(i+1)) ms の件数
+        std::array<uint64_t, histogramBuckets> latencyHistogram{};
+    };
+    Snapshot snapshot();
+
+    // 全カウンタをゼロに戻す（記録と並行した場合、近傍の数件が失われうる）
+    void reset();
+
+  private:
+    struct ThreadSlot
+    {
+        std::atomic<uint64_t> frames{0};
+        std::atomic<uint64_t> decodeUs{0};
+        std::atomic<uint64_t> preprocessUs{0};
+        std::atomic<uint64_t> forwardUs{0};
+        std::atomic<uint64_t> postprocessUs{0};
+        std::atomic<uint64_t> detections{0};
+        std::atomic<uint64_t> inputBytes{0};
+        std::atomic<uint64_t> cacheHits{0};
+        std::atomic<uint64_t> cacheMisses{0};
+        std::array<std::atomic<uint64_t>, histogramBuckets> histogram{};
+    };
+
+    ThreadSlot *slotForThisThread();
+
+    std::mutex registryMtx;                 // スロット登録時のみ使用
+    std::vector<ThreadSlot *> slots;        // 全スレッドのスロット
+};
+#endif